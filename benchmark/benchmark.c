@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <math.h>
 #include "../src/memory.h"
+#include "counters.h"
 
 #ifdef _WIN32
 #include <windows.h>
@@ -31,12 +32,14 @@ double measures[N];
 double mean;
 double standard_deviation;
 void *malloc_data[N];
+struct counters counters;
 
 void measure_walloc(void){
   void *arena = _Wcreate_arena(ALLOC_SIZE * N + 1024);
   int i;
   void *v;
   double elapsed, sum = 0, dif_squared = 0;
+  counters_start(&counters);
   for(i = 0; i < N; i ++){
     TIMER_START();
     v = _Walloc(arena, 0, 0, ALLOC_SIZE);
@@ -44,6 +47,7 @@ void measure_walloc(void){
 	((char*)v)[0] = 'W';
     measures[i] = elapsed;
   }
+  counters_stop(&counters);
   for(i = 0; i < N; i ++)
     sum += measures[i];
   mean = sum / N;
@@ -51,17 +55,20 @@ void measure_walloc(void){
     dif_squared += (measures[i] - mean) * (measures[i] - mean);
   standard_deviation = sqrt(dif_squared / (N - 1));
   printf("Walloc: %.15f seconds ± %.15f seconds\n", mean, standard_deviation);
+  counters_print_text(stdout, &counters, N);
 }
 
 void measure_malloc(void){
   int i;
   double elapsed, sum = 0, dif_squared = 0;
+  counters_start(&counters);
   for(i = 0; i < N; i ++){
     TIMER_START();
     malloc_data[i] = malloc(ALLOC_SIZE);
     TIMER_END();
     measures[i] = elapsed;
   }
+  counters_stop(&counters);
   for(i = 0; i < N; i ++)
     sum += measures[i];
   mean = sum / N;
@@ -69,17 +76,20 @@ void measure_malloc(void){
     dif_squared += (measures[i] - mean) * (measures[i] - mean);
   standard_deviation = sqrt(dif_squared / (N - 1));
   printf("Malloc: %.15f seconds ± %.15f seconds\n", mean, standard_deviation);
+  counters_print_text(stdout, &counters, N);
 }
 
 void measure_free(void){
   int i;
   double elapsed, sum = 0, dif_squared = 0;
+  counters_start(&counters);
   for(i = 0; i < N; i ++){
     TIMER_START();
     free(malloc_data[i]);
     TIMER_END();
     measures[i] = elapsed;
   }
+  counters_stop(&counters);
   for(i = 0; i < N; i ++)
     sum += measures[i];
   mean = sum / N;
@@ -87,18 +97,21 @@ void measure_free(void){
     dif_squared += (measures[i] - mean) * (measures[i] - mean);
   standard_deviation = sqrt(dif_squared / (N - 1));
   printf("Free: %.15f seconds ± %.15f seconds\n", mean, standard_deviation);
+  counters_print_text(stdout, &counters, N);
 }
 
 void measure_wmempoint_wtrash(void){
   void *arena = _Wcreate_arena(ALLOC_SIZE * N + 1024);
   int i;
   double elapsed, sum = 0, dif_squared = 0;
+  counters_start(&counters);
   for(i = 0; i < N; i ++){
     TIMER_START();
     _Wmempoint(arena, 0, 0);
     TIMER_END();
     measures[i] = elapsed;
   }
+  counters_stop(&counters);
   for(i = 0; i < N; i ++)
     sum += measures[i];
   mean = sum / N;
@@ -106,14 +119,17 @@ void measure_wmempoint_wtrash(void){
     dif_squared += (measures[i] - mean) * (measures[i] - mean);
   standard_deviation = sqrt(dif_squared / (N - 1));
   printf("Wmempoint: %.15f seconds ± %.15f seconds\n", mean, standard_deviation);
+  counters_print_text(stdout, &counters, N);
   sum = 0;
   dif_squared = 0;
+  counters_start(&counters);
   for(i = 0; i < N; i ++){
     TIMER_START();
     _Wtrash(arena, 0);
     TIMER_END();
     measures[i] = elapsed;
   }
+  counters_stop(&counters);
   for(i = 0; i < N; i ++)
     sum += measures[i];
   mean = sum / N;
@@ -121,12 +137,15 @@ void measure_wmempoint_wtrash(void){
     dif_squared += (measures[i] - mean) * (measures[i] - mean);
   standard_deviation = sqrt(dif_squared / (N - 1));
   printf("Wtrash: %.15f seconds ± %.15f seconds\n", mean, standard_deviation);
+  counters_print_text(stdout, &counters, N);
 }
 
 int main(int argc, char **argv){
+  counters_open(&counters);
   measure_malloc();
   measure_free();
   measure_walloc();
   measure_wmempoint_wtrash();
+  counters_close(&counters);
   return 0;
 }
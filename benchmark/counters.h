@@ -0,0 +1,137 @@
+#ifndef WEAVER_BENCHMARK_COUNTERS
+#define WEAVER_BENCHMARK_COUNTERS
+
+/* Hardware and software performance counters read with Linux
+   perf_event_open around a measured phase. Counters which can't be
+   opened (other systems, no permission, virtual machines without a
+   PMU) are marked as unavailable and printed as empty CSV fields.
+   The counters must be opened before creating threads, so that the
+   threads inherit them. */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#define NUMBER_OF_COUNTERS 6
+
+struct counters{
+  int fd[NUMBER_OF_COUNTERS];
+  uint64_t value[NUMBER_OF_COUNTERS];
+};
+
+static const char *counter_name[NUMBER_OF_COUNTERS] = {
+  "cycles", "instructions", "l1d_misses", "llc_misses", "dtlb_misses",
+  "page_faults"};
+
+static inline void counters_open(struct counters *c){
+  int i;
+  bool any = false;
+#if defined(__linux__)
+  const uint32_t type[NUMBER_OF_COUNTERS] = {
+    PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE,
+    PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE, PERF_TYPE_SOFTWARE};
+  const uint64_t config[NUMBER_OF_COUNTERS] = {
+    PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+    (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+    (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+    PERF_COUNT_SW_PAGE_FAULTS};
+  for(i = 0; i < NUMBER_OF_COUNTERS; i ++){
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type[i];
+    attr.config = config[i];
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = (type[i] != PERF_TYPE_SOFTWARE);
+    attr.exclude_hv = 1;
+    c -> fd[i] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    if(c -> fd[i] >= 0)
+      any = true;
+  }
+#else
+  for(i = 0; i < NUMBER_OF_COUNTERS; i ++)
+    c -> fd[i] = -1;
+#endif
+  if(!any)
+    fprintf(stderr, "Performance counters not available\n");
+}
+
+static inline void counters_start(struct counters *c){
+#if defined(__linux__)
+  int i;
+  for(i = 0; i < NUMBER_OF_COUNTERS; i ++)
+    if(c -> fd[i] >= 0){
+      ioctl(c -> fd[i], PERF_EVENT_IOC_RESET, 0);
+      ioctl(c -> fd[i], PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+}
+
+static inline void counters_stop(struct counters *c){
+  int i;
+  for(i = 0; i < NUMBER_OF_COUNTERS; i ++){
+    c -> value[i] = 0;
+#if defined(__linux__)
+    if(c -> fd[i] >= 0){
+      ioctl(c -> fd[i], PERF_EVENT_IOC_DISABLE, 0);
+      if(read(c -> fd[i], &(c -> value[i]), sizeof(uint64_t)) !=
+         sizeof(uint64_t))
+        c -> value[i] = 0;
+    }
+#endif
+  }
+}
+
+static inline void counters_close(struct counters *c){
+#if defined(__linux__)
+  int i;
+  for(i = 0; i < NUMBER_OF_COUNTERS; i ++)
+    if(c -> fd[i] >= 0)
+      close(c -> fd[i]);
+#endif
+}
+
+/* Prints the CSV header fields and the counts divided by the number of
+   operations, each one preceded by a comma. */
+static inline void counters_print_header(FILE *f){
+  int i;
+  for(i = 0; i < NUMBER_OF_COUNTERS; i ++)
+    fprintf(f, ",%s_per_op", counter_name[i]);
+}
+
+static inline void counters_print(FILE *f, struct counters *c, size_t operations){
+  int i;
+  for(i = 0; i < NUMBER_OF_COUNTERS; i ++)
+    if(c -> fd[i] >= 0)
+      fprintf(f, ",%.3f", ((double) c -> value[i]) / operations);
+    else
+      fprintf(f, ",");
+}
+
+/* The same values in a human readable line, for benchmark.c */
+static inline void counters_print_text(FILE *f, struct counters *c,
+                                       size_t operations){
+  int i;
+  bool any = false;
+  for(i = 0; i < NUMBER_OF_COUNTERS; i ++)
+    if(c -> fd[i] >= 0){
+      fprintf(f, "%s%s: %.3f", (any)?(", "):("    "), counter_name[i],
+              ((double) c -> value[i]) / operations);
+      any = true;
+    }
+  if(any)
+    fprintf(f, " (per operation)\n");
+}
+
+#endif
@@ -0,0 +1,259 @@
+#if defined(__linux__)
+#define _GNU_SOURCE // Include 'sched_setaffinity'
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include "../src/memory.h"
+#include "counters.h"
+
+/* Latency harness. Measures each single operation with the time stamp
+   counter, subtracts the timer overhead and prints the percentiles of
+   the latencies in nanoseconds as CSV. Usage:
+   ./bench-latency [CORE]
+   If CORE is given, the program runs pinned to that core. The
+   performance counters are read around the whole pass whose samples
+   are kept, so they also count the timer instructions. */
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#if defined(__linux__)
+#include <sched.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define W_RDTSC
+#endif
+
+#define N            100000
+#define ARENAS       1000
+#define WARMUP       2
+#define ALLOC_SIZE   64
+#define ARENA_SIZE   (1024 * 1024)
+
+uint64_t samples[N];
+void *pointers[N];
+double ticks_per_ns;
+uint64_t timer_overhead;
+struct counters counters;
+
+static uint64_t nanoseconds(void){
+#if defined(_WIN32)
+  LARGE_INTEGER t, f;
+  QueryPerformanceFrequency(&f);
+  QueryPerformanceCounter(&t);
+  return (uint64_t) (t.QuadPart * (1000000000.0 / f.QuadPart));
+#else
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return ((uint64_t) t.tv_sec) * 1000000000ull + t.tv_nsec;
+#endif
+}
+
+/* The fence before reading the counter at the beginning prevents
+   previous instructions from being measured, and rdtscp at the end
+   waits for the measured instructions. Without a time stamp counter,
+   we use the monotonic clock and a tick is a nanosecond. */
+static inline uint64_t timer_start(void){
+#if defined(W_RDTSC)
+  _mm_lfence();
+  return __rdtsc();
+#else
+  return nanoseconds();
+#endif
+}
+static inline uint64_t timer_end(void){
+#if defined(W_RDTSC)
+  unsigned aux;
+  uint64_t t = __rdtscp(&aux);
+  _mm_lfence();
+  return t;
+#else
+  return nanoseconds();
+#endif
+}
+
+/* The tick frequency is measured against the monotonic clock, and the
+   overhead is the smallest time measured for an empty region. */
+static void calibrate(void){
+  uint64_t t0, t1, n0, n1;
+  int i;
+#if defined(W_RDTSC)
+  n0 = nanoseconds();
+  t0 = timer_start();
+  do{
+    n1 = nanoseconds();
+  } while(n1 - n0 < 100000000); // 100 ms
+  t1 = timer_end();
+  ticks_per_ns = ((double) (t1 - t0)) / (n1 - n0);
+#else
+  (void) n0; (void) n1;
+  ticks_per_ns = 1.0;
+#endif
+  timer_overhead = UINT64_MAX;
+  for(i = 0; i < N; i ++){
+    t0 = timer_start();
+    t1 = timer_end();
+    if(t1 - t0 < timer_overhead)
+      timer_overhead = t1 - t0;
+  }
+}
+
+static bool pin_to_core(int core){
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(core, &set);
+  return sched_setaffinity(0, sizeof(set), &set) == 0;
+#elif defined(_WIN32)
+  return SetThreadAffinityMask(GetCurrentThread(),
+                               ((DWORD_PTR) 1) << core) != 0;
+#else
+  (void) core;
+  return false;
+#endif
+}
+
+static int compare_samples(const void *a, const void *b){
+  uint64_t s1 = *(const uint64_t *) a, s2 = *(const uint64_t *) b;
+  return (s1 < s2)?(-1):((s1 > s2)?(1):(0));
+}
+
+static double percentile(size_t n, double p){
+  size_t i = (size_t) (p * (n - 1) + 0.5);
+  return samples[i] / ticks_per_ns;
+}
+
+static void report(const char *operation, size_t n){
+  qsort(samples, n, sizeof(uint64_t), compare_samples);
+  printf("%s,%zu,%.1f,%.1f,%.1f,%.1f,%.1f", operation, n,
+         percentile(n, 0.5), percentile(n, 0.9), percentile(n, 0.99),
+         percentile(n, 0.999), samples[n - 1] / ticks_per_ns);
+  counters_print(stdout, &counters, n);
+  printf("\n");
+  fflush(stdout);
+}
+
+#define START_PHASE() if(pass == WARMUP) counters_start(&counters)
+#define END_PHASE() if(pass == WARMUP) counters_stop(&counters)
+
+#define MEASURE(i, code) {                                  \
+    uint64_t t0, t1;                                        \
+    t0 = timer_start();                                     \
+    code;                                                   \
+    t1 = timer_end();                                       \
+    t1 -= t0;                                               \
+    samples[i] = (t1 > timer_overhead)?(t1 - timer_overhead):(0); }
+
+/* Each operation runs WARMUP times before the pass whose samples are
+   kept, so that pages, caches and branch predictors are warm. */
+static void measure_walloc(void){
+  void *arena = _Wcreate_arena((ALLOC_SIZE + 64) * N);
+  int i, pass;
+  for(pass = 0; pass <= WARMUP; pass ++){
+    START_PHASE();
+    for(i = 0; i < N; i ++)
+      MEASURE(i, pointers[i] = _Walloc(arena, 0, 0, ALLOC_SIZE));
+    END_PHASE();
+    _Wtrash(arena, 0);
+  }
+  report("walloc", N);
+  _Wdestroy_arena(arena);
+}
+
+static void measure_walloc_inline(void){
+  void *arena = _Wcreate_arena((ALLOC_SIZE + 64) * N);
+  int i, pass;
+  for(pass = 0; pass <= WARMUP; pass ++){
+    START_PHASE();
+    for(i = 0; i < N; i ++)
+      MEASURE(i, pointers[i] = _Walloc_inline(arena, 0, 0, ALLOC_SIZE));
+    END_PHASE();
+    _Wtrash(arena, 0);
+  }
+  report("walloc_inline", N);
+  _Wdestroy_arena(arena);
+}
+
+static void measure_wmempoint_wtrash(void){
+  void *arena = _Wcreate_arena(128 * N);
+  int i, pass;
+  for(pass = 0; pass <= WARMUP; pass ++){
+    START_PHASE();
+    for(i = 0; i < N; i ++)
+      MEASURE(i, _Wmempoint(arena, 0, 0));
+    END_PHASE();
+    if(pass == WARMUP)
+      report("wmempoint", N);
+    START_PHASE();
+    for(i = 0; i < N; i ++)
+      MEASURE(i, _Wtrash(arena, 0));
+    END_PHASE();
+  }
+  report("wtrash", N);
+  _Wdestroy_arena(arena);
+}
+
+static void measure_arenas(void){
+  int i, pass;
+  for(pass = 0; pass <= WARMUP; pass ++){
+    START_PHASE();
+    for(i = 0; i < ARENAS; i ++)
+      MEASURE(i, pointers[i] = _Wcreate_arena(ARENA_SIZE));
+    END_PHASE();
+    if(pass == WARMUP)
+      report("wcreate_arena", ARENAS);
+    START_PHASE();
+    for(i = 0; i < ARENAS; i ++)
+      MEASURE(i, _Wdestroy_arena(pointers[i]));
+    END_PHASE();
+  }
+  report("wdestroy_arena", ARENAS);
+}
+
+static void measure_malloc_free(void){
+  int i, pass;
+  for(pass = 0; pass <= WARMUP; pass ++){
+    START_PHASE();
+    for(i = 0; i < N; i ++)
+      MEASURE(i, pointers[i] = malloc(ALLOC_SIZE));
+    END_PHASE();
+    if(pass == WARMUP)
+      report("malloc", N);
+    START_PHASE();
+    for(i = 0; i < N; i ++)
+      MEASURE(i, free(pointers[i]));
+    END_PHASE();
+  }
+  report("free", N);
+}
+
+int main(int argc, char **argv){
+  if(argc > 1 && !pin_to_core(atoi(argv[1])))
+    fprintf(stderr, "Could not pin to core %s\n", argv[1]);
+  counters_open(&counters);
+  calibrate();
+  fprintf(stderr, "Timer: %s, %.3f ticks/ns, overhead %llu ticks\n",
+#if defined(W_RDTSC)
+          "rdtsc",
+#else
+          "monotonic clock",
+#endif
+          ticks_per_ns, (unsigned long long) timer_overhead);
+  printf("operation,samples,p50_ns,p90_ns,p99_ns,p99.9_ns,max_ns");
+  counters_print_header(stdout);
+  printf("\n");
+  measure_malloc_free();
+  measure_walloc();
+  measure_walloc_inline();
+  measure_wmempoint_wtrash();
+  measure_arenas();
+  counters_close(&counters);
+  return 0;
+}
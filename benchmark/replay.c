@@ -0,0 +1,419 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../src/memory.h"
+
+/* Replays a trace recorded by a program compiled with W_TRACE, first
+   with arenas and then with malloc/free, and prints the time of
+   each. Usage: ./replay trace.bin */
+
+#ifdef _WIN32
+#include <windows.h>
+#define TIMER_START() { LARGE_INTEGER t1, f, t2, e;		\
+  QueryPerformanceFrequency(&f); QueryPerformanceCounter(&t1);
+#define TIMER_END() QueryPerformanceCounter(&t2); \
+  e.QuadPart = t2.QuadPart - t1.QuadPart; \
+  e.QuadPart *= 1000000; \
+  e.QuadPart /= f.QuadPart; \
+  elapsed = ((double)e.QuadPart) *1e-6; }
+#else
+#include <time.h>
+#define TIMER_START() { struct timespec t1, t2;	\
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+#define TIMER_END() clock_gettime(CLOCK_MONOTONIC, &t2);	\
+  elapsed = t2.tv_sec + t2.tv_nsec*1e-9 - t1.tv_sec - t1.tv_nsec*1e-9; }
+#endif
+
+/* Each traced arena is replayed in a new arena. For malloc, each
+   stack is a list of allocations where NULL marks a memory point. Marks
+   are identified by the offset recorded when they were set, and keep
+   the replayed mark or the size of the malloc list. */
+struct mark{
+  uint64_t offset;
+  struct _Wmark mark;
+  size_t size;
+};
+struct stack{
+  void **p;
+  size_t size, capacity;
+  struct mark *marks;
+  size_t number_of_marks, marks_capacity;
+};
+struct replayed_arena{
+  uint64_t id;
+  bool alive;
+  void *arena;
+  struct stack stack[2];
+};
+
+struct _Wtrace_event *events;
+size_t number_of_events;
+struct replayed_arena *arenas;
+size_t number_of_arenas;
+
+int compare_events(const void *a, const void *b){
+  const struct _Wtrace_event *e1 = (const struct _Wtrace_event *) a;
+  const struct _Wtrace_event *e2 = (const struct _Wtrace_event *) b;
+  if(e1 -> time != e2 -> time)
+    return (e1 -> time < e2 -> time)?(-1):(1);
+  /* Same time: keep the order in which each thread recorded them */
+  if(e1 -> thread != e2 -> thread)
+    return (e1 -> thread < e2 -> thread)?(-1):(1);
+  return (e1 -> sequence < e2 -> sequence)?(-1):
+    ((e1 -> sequence > e2 -> sequence)?(1):(0));
+}
+
+bool read_trace(const char *filename){
+  FILE *file = fopen(filename, "rb");
+  size_t capacity = 1024;
+  if(file == NULL)
+    return false;
+  events = (struct _Wtrace_event *) malloc(capacity * sizeof(struct _Wtrace_event));
+  number_of_events = 0;
+  while(events != NULL){
+    number_of_events += fread(events + number_of_events,
+                              sizeof(struct _Wtrace_event),
+                              capacity - number_of_events, file);
+    if(number_of_events < capacity)
+      break;
+    capacity *= 2;
+    events = (struct _Wtrace_event *)
+      realloc(events, capacity * sizeof(struct _Wtrace_event));
+  }
+  fclose(file);
+  if(events == NULL)
+    return false;
+  qsort(events, number_of_events, sizeof(struct _Wtrace_event),
+        compare_events);
+  return true;
+}
+
+struct replayed_arena *find_arena(uint64_t id, bool create){
+  size_t i;
+  for(i = number_of_arenas; i > 0; i --)
+    if(arenas[i - 1].id == id && arenas[i - 1].alive)
+      return &(arenas[i - 1]);
+  if(!create)
+    return NULL;
+  arenas = (struct replayed_arena *)
+    realloc(arenas, (number_of_arenas + 1) * sizeof(struct replayed_arena));
+  memset(&(arenas[number_of_arenas]), 0, sizeof(struct replayed_arena));
+  arenas[number_of_arenas].id = id;
+  arenas[number_of_arenas].alive = true;
+  return &(arenas[number_of_arenas ++]);
+}
+
+void push(struct stack *s, void *p){
+  if(s -> size == s -> capacity){
+    s -> capacity = (s -> capacity)?(2 * s -> capacity):(1024);
+    s -> p = (void **) realloc(s -> p, s -> capacity * sizeof(void *));
+  }
+  s -> p[s -> size ++] = p;
+}
+
+void push_mark(struct stack *s, uint64_t offset, struct _Wmark *mark){
+  if(s -> number_of_marks == s -> marks_capacity){
+    s -> marks_capacity = (s -> marks_capacity)?(2 * s -> marks_capacity):(64);
+    s -> marks = (struct mark *)
+      realloc(s -> marks, s -> marks_capacity * sizeof(struct mark));
+  }
+  s -> marks[s -> number_of_marks].offset = offset;
+  if(mark != NULL)
+    s -> marks[s -> number_of_marks].mark = *mark;
+  s -> marks[s -> number_of_marks].size = s -> size;
+  s -> number_of_marks ++;
+}
+
+/* Restoring a mark discards the marks set after it */
+struct mark *find_mark(struct stack *s, uint64_t offset){
+  size_t i;
+  for(i = s -> number_of_marks; i > 0; i --)
+    if(s -> marks[i - 1].offset == offset){
+      s -> number_of_marks = i;
+      return &(s -> marks[i - 1]);
+    }
+  return NULL;
+}
+
+void free_marks(struct stack *s){
+  free(s -> marks);
+  s -> marks = NULL;
+  s -> number_of_marks = s -> marks_capacity = 0;
+}
+
+void free_until_mempoint(struct stack *s){
+  while(s -> size > 0){
+    s -> size --;
+    if(s -> p[s -> size] == NULL)
+      return;
+    free(s -> p[s -> size]);
+  }
+}
+
+void free_until_size(struct stack *s, size_t size){
+  while(s -> size > size){
+    s -> size --;
+    free(s -> p[s -> size]);
+  }
+}
+
+/* Removes the last memory point, keeping the allocations after it */
+void commit_mempoint(struct stack *s){
+  size_t i, j;
+  for(i = s -> size; i > 0; i --)
+    if(s -> p[i - 1] == NULL){
+      memmove(&(s -> p[i - 1]), &(s -> p[i]), (s -> size - i) * sizeof(void *));
+      s -> size --;
+      for(j = 0; j < s -> number_of_marks; j ++)
+        if(s -> marks[j].size >= i)
+          s -> marks[j].size --;
+      return;
+    }
+}
+
+void free_stack(struct stack *s){
+  while(s -> size > 0)
+    free_until_mempoint(s);
+  free(s -> p);
+  s -> p = NULL;
+  s -> capacity = 0;
+  free_marks(s);
+}
+
+/* A batch is recorded as one event per allocation, with the same time
+   and the number of allocations in the first one. Replays the batch
+   beginning in events[first] and returns how many events it used. */
+size_t replay_batch(void *arena, size_t first, size_t *different){
+  size_t i, count = events[first].previous_size;
+  size_t *sizes;
+  unsigned *alignments;
+  void **out;
+  if(count == 0 || first + count > number_of_events)
+    return 1;
+  sizes = (size_t *) malloc(count * sizeof(size_t));
+  alignments = (unsigned *) malloc(count * sizeof(unsigned));
+  out = (void **) malloc(count * sizeof(void *));
+  if(sizes != NULL && alignments != NULL && out != NULL){
+    for(i = 0; i < count; i ++){
+      sizes[i] = events[first + i].size;
+      alignments[i] = events[first + i].alignment;
+    }
+    _Walloc_batch(arena, events[first].right, count, sizes, alignments, out);
+    for(i = 0; i < count; i ++)
+      if((out[i] == NULL && events[first + i].offset != UINT64_MAX) ||
+         (out[i] != NULL && (uint64_t) ((char *) out[i] - (char *) arena) !=
+          events[first + i].offset))
+        (*different) ++;
+  }
+  free(sizes);
+  free(alignments);
+  free(out);
+  return count;
+}
+
+/* Events of arenas created before the trace began are ignored. The
+   number of allocations whose offset is not the same as in the trace
+   shows how faithful the replay was. */
+void replay_arena(size_t *ignored, size_t *different){
+  size_t i;
+  double elapsed;
+  *ignored = *different = 0;
+  number_of_arenas = 0;
+  TIMER_START();
+  for(i = 0; i < number_of_events; i ++){
+    struct _Wtrace_event *e = &(events[i]);
+    struct replayed_arena *a;
+    struct mark *m;
+    void *p = NULL;
+    if(e -> type == W_TRACE_CREATE){
+      if(e -> offset != UINT64_MAX){
+        /* If the arena can't be created here, as with W_LOCKED over
+           the memory lock limit, its events are ignored */
+        p = _Wcreate_arena_flags(e -> size, e -> alignment);
+        if(p == NULL){
+          fprintf(stderr, "Could not create arena with %llu bytes\n",
+                  (unsigned long long) e -> size);
+          (*ignored) ++;
+        }
+        else
+          find_arena(e -> arena, true) -> arena = p;
+      }
+      continue;
+    }
+    a = find_arena(e -> arena, false);
+    if(a == NULL){
+      (*ignored) ++;
+      continue;
+    }
+    switch(e -> type){
+    case W_TRACE_ALLOC:
+      p = _Walloc(a -> arena, e -> alignment, e -> right, e -> size);
+      break;
+    case W_TRACE_MEMPOINT:
+      _Wmempoint(a -> arena, e -> alignment, e -> right);
+      break;
+    case W_TRACE_TRASH:
+      _Wtrash(a -> arena, e -> right);
+      break;
+    case W_TRACE_MARK:
+      {
+        struct _Wmark mark;
+        _Wset_mark(a -> arena, e -> right, &mark);
+        push_mark(&(a -> stack[e -> right]), e -> offset, &mark);
+      }
+      break;
+    case W_TRACE_TRASH_TO:
+      if(e -> offset != UINT64_MAX &&
+         (m = find_mark(&(a -> stack[e -> right]), e -> offset)) != NULL)
+        _Wtrash_to(a -> arena, &(m -> mark));
+      break;
+    case W_TRACE_COMMIT:
+      if(e -> offset != UINT64_MAX)
+        _Wcommit(a -> arena, e -> right);
+      break;
+    case W_TRACE_POP:
+      if(e -> offset != UINT64_MAX)
+        _Wpop(a -> arena, e -> right, (char *) a -> arena + e -> offset,
+              e -> size);
+      break;
+    case W_TRACE_REALLOC:
+      _Wrealloc(a -> arena, e -> alignment, e -> right,
+                (char *) a -> arena + e -> offset, e -> previous_size,
+                e -> size);
+      break;
+    case W_TRACE_BATCH:
+      i += replay_batch(a -> arena, i, different) - 1;
+      break;
+    case W_TRACE_DESTROY:
+      _Wdestroy_arena(a -> arena);
+      free_marks(&(a -> stack[0]));
+      free_marks(&(a -> stack[1]));
+      a -> alive = false;
+      break;
+    }
+    if(e -> type == W_TRACE_ALLOC &&
+       ((p == NULL && e -> offset != UINT64_MAX) ||
+        (p != NULL && (uint64_t) ((char *) p - (char *) a -> arena) !=
+         e -> offset)))
+      (*different) ++;
+  }
+  for(i = 0; i < number_of_arenas; i ++)
+    if(arenas[i].alive){
+      _Wdestroy_arena(arenas[i].arena);
+      free_marks(&(arenas[i].stack[0]));
+      free_marks(&(arenas[i].stack[1]));
+    }
+  TIMER_END();
+  printf("Arena:  %.9f seconds\n", elapsed);
+  free(arenas);
+  arenas = NULL;
+}
+
+void replay_malloc(void){
+  size_t i;
+  double elapsed;
+  number_of_arenas = 0;
+  TIMER_START();
+  for(i = 0; i < number_of_events; i ++){
+    struct _Wtrace_event *e = &(events[i]);
+    struct replayed_arena *a;
+    if(e -> type == W_TRACE_CREATE){
+      if(e -> offset != UINT64_MAX)
+        find_arena(e -> arena, true);
+      continue;
+    }
+    a = find_arena(e -> arena, false);
+    if(a == NULL)
+      continue;
+    switch(e -> type){
+    case W_TRACE_ALLOC:
+      if(e -> offset != UINT64_MAX)
+        push(&(a -> stack[e -> right]), malloc(e -> size));
+      break;
+    case W_TRACE_MEMPOINT:
+      if(e -> offset != UINT64_MAX)
+        push(&(a -> stack[e -> right]), NULL);
+      break;
+    case W_TRACE_TRASH:
+      {
+        struct stack *s = &(a -> stack[e -> right]);
+        free_until_mempoint(s);
+        /* Marks set after the memory point can't be restored anymore */
+        while(s -> number_of_marks > 0 &&
+              s -> marks[s -> number_of_marks - 1].size > s -> size)
+          s -> number_of_marks --;
+      }
+      break;
+    case W_TRACE_MARK:
+      push_mark(&(a -> stack[e -> right]), e -> offset, NULL);
+      break;
+    case W_TRACE_TRASH_TO:
+      {
+        struct mark *m = NULL;
+        if(e -> offset != UINT64_MAX)
+          m = find_mark(&(a -> stack[e -> right]), e -> offset);
+        if(m != NULL)
+          free_until_size(&(a -> stack[e -> right]), m -> size);
+      }
+      break;
+    case W_TRACE_COMMIT:
+      if(e -> offset != UINT64_MAX)
+        commit_mempoint(&(a -> stack[e -> right]));
+      break;
+    case W_TRACE_POP:
+      {
+        struct stack *s = &(a -> stack[e -> right]);
+        if(e -> offset != UINT64_MAX && s -> size > 0 &&
+           s -> p[s -> size - 1] != NULL)
+          free(s -> p[-- (s -> size)]);
+      }
+      break;
+    case W_TRACE_REALLOC:
+      {
+        struct stack *s = &(a -> stack[e -> right]);
+        if(s -> size > 0 && s -> p[s -> size - 1] != NULL)
+          s -> p[s -> size - 1] = realloc(s -> p[s -> size - 1], e -> size);
+      }
+      break;
+    case W_TRACE_BATCH:
+      if(e -> offset != UINT64_MAX)
+        push(&(a -> stack[e -> right]), malloc(e -> size));
+      break;
+    case W_TRACE_DESTROY:
+      free_stack(&(a -> stack[0]));
+      free_stack(&(a -> stack[1]));
+      a -> alive = false;
+      break;
+    }
+  }
+  for(i = 0; i < number_of_arenas; i ++){
+    free_stack(&(arenas[i].stack[0]));
+    free_stack(&(arenas[i].stack[1]));
+  }
+  TIMER_END();
+  printf("Malloc: %.9f seconds\n", elapsed);
+  free(arenas);
+  arenas = NULL;
+}
+
+int main(int argc, char **argv){
+  size_t ignored, different;
+  if(argc < 2){
+    fprintf(stderr, "Usage: %s TRACE_FILE\n", argv[0]);
+    return 1;
+  }
+  if(!read_trace(argv[1])){
+    fprintf(stderr, "Could not read trace '%s'\n", argv[1]);
+    return 1;
+  }
+  printf("Events: %zu\n", number_of_events);
+  if(number_of_events > 0)
+    printf("Traced: %.9f seconds\n",
+           (events[number_of_events - 1].time - events[0].time) * 1e-9);
+  replay_arena(&ignored, &different);
+  replay_malloc();
+  printf("Ignored events: %zu\n", ignored);
+  printf("Allocations with different offsets: %zu\n", different);
+  free(events);
+  return 0;
+}
@@ -0,0 +1,314 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../src/memory.h"
+#include "counters.h"
+
+/* Throughput benchmark suite. Each measurement runs a fixed number of
+   operations in every thread, all threads starting at the same time
+   and sharing a single arena, and reports the median of several
+   repetitions as CSV in the standard output. Usage:
+   ./bench-suite [MAX_THREADS] */
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#define OPERATIONS   65536 // Per thread and repetition
+#define REPETITIONS  5
+#define FRAMES       256
+#define FRAME_ALLOCS 256
+#define TABLE_SIZE   4096 // Must divide OPERATIONS and FRAMES * FRAME_ALLOCS
+#define BUFFER_SIZE  (64 * 1024)
+#define MAX_THREADS  64
+
+enum allocator{WALLOC, WALLOC_INLINE, WBUFFER, MALLOC};
+const char *allocator_name[] = {"walloc", "walloc_inline", "wbuffer", "malloc"};
+enum workload{ALLOC, FRAME};
+const char *workload_name[] = {"alloc", "frame"};
+const char *stack_name[] = {"left", "right", "both"};
+
+/* Sizes are read from a table, so that the same sequence is used by
+   all allocators. The 'mixed' distribution has mostly small objects
+   and a few big ones: 70% between 16 and 64 bytes, 25% up to 512 and
+   5% up to 4096. */
+size_t fixed_sizes[TABLE_SIZE], mixed_sizes[TABLE_SIZE];
+size_t table_sum[2];
+
+/* Counters are summed over the repetitions of a measure */
+struct counters counters;
+uint64_t counter_sum[NUMBER_OF_COUNTERS];
+
+struct measure{
+  enum workload workload;
+  enum allocator allocator;
+  size_t *sizes;
+  int stack; // 0: left, 1: right, 2: alternate
+  unsigned alignment;
+  void *arena[MAX_THREADS];
+  int start;
+};
+struct thread_data{
+  struct measure *measure;
+  unsigned id;
+  void **out;
+};
+
+static double now(void){
+#if defined(_WIN32)
+  LARGE_INTEGER t, f;
+  QueryPerformanceFrequency(&f);
+  QueryPerformanceCounter(&t);
+  return ((double) t.QuadPart) / f.QuadPart;
+#else
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+#endif
+}
+
+static unsigned number_of_cores(void){
+#if defined(_WIN32)
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return info.dwNumberOfProcessors;
+#else
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return (n > 0)?((unsigned) n):(1);
+#endif
+}
+
+static void init_tables(void){
+  unsigned long long seed = 42;
+  int i;
+  table_sum[0] = table_sum[1] = 0;
+  for(i = 0; i < TABLE_SIZE; i ++){
+    unsigned r;
+    seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+    r = (unsigned) (seed >> 33);
+    fixed_sizes[i] = 64;
+    if(r % 100 < 70)
+      mixed_sizes[i] = 16 + (r / 100) % 49;
+    else if(r % 100 < 95)
+      mixed_sizes[i] = 65 + (r / 100) % 448;
+    else
+      mixed_sizes[i] = 513 + (r / 100) % 3584;
+    table_sum[0] += fixed_sizes[i];
+    table_sum[1] += mixed_sizes[i];
+  }
+}
+
+/* Allocation workload: every thread allocates OPERATIONS objects in
+   the shared arena. Frame workload: every thread runs FRAMES cycles of
+   memory point, FRAME_ALLOCS allocations and trash. As memory points
+   belong to a stack and not to a thread, each thread runs its frames
+   in its own arena. */
+static void run_thread(struct thread_data *data){
+  struct measure *m = data -> measure;
+  void *arena = m -> arena[(m -> workload == FRAME)?(data -> id):(0)];
+  unsigned a = m -> alignment;
+  size_t i, j, operations = OPERATIONS, frames = 1;
+  size_t offset = (data -> id * 997) % TABLE_SIZE;
+  struct _Wbuffer buffer;
+  void **out = data -> out;
+  if(m -> workload == FRAME){
+    frames = FRAMES;
+    operations = FRAME_ALLOCS;
+  }
+  while(!__atomic_load_n(&(m -> start), __ATOMIC_ACQUIRE));
+  if(m -> allocator == WBUFFER)
+    _Winit_buffer(&buffer, arena, m -> stack == 1, BUFFER_SIZE);
+  for(j = 0; j < frames; j ++){
+    if(m -> workload == FRAME && m -> allocator != MALLOC)
+      _Wmempoint(arena, 0, 0);
+    for(i = 0; i < operations; i ++){
+      size_t t = m -> sizes[(offset + i) % TABLE_SIZE];
+      int right = (m -> stack == 2)?((int) (i % 2)):(m -> stack);
+      switch(m -> allocator){
+      case WALLOC:
+        out[i] = _Walloc(arena, a, right, t);
+        break;
+      case WALLOC_INLINE:
+        out[i] = _Walloc_inline(arena, a, right, t);
+        break;
+      case WBUFFER:
+        out[i] = _Walloc_buffer(&buffer, a, t);
+        break;
+      case MALLOC:
+        out[i] = malloc(t);
+        break;
+      }
+    }
+    if(m -> workload == FRAME){
+      if(m -> allocator == MALLOC)
+        for(i = 0; i < operations; i ++)
+          free(out[i]);
+      else
+        _Wtrash(arena, 0);
+    }
+  }
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI thread_function(LPVOID data){
+  run_thread((struct thread_data *) data);
+  return 0;
+}
+#else
+static void *thread_function(void *data){
+  run_thread((struct thread_data *) data);
+  return NULL;
+}
+#endif
+
+/* Returns the time spent by the slowest thread, from the moment all
+   of them are allowed to start. Arenas are created before and
+   destroyed after the measure, with their pages already touched. */
+static double run(struct measure *m, unsigned threads){
+  struct thread_data data[MAX_THREADS];
+  double begin, end;
+  unsigned i, number_of_arenas = (m -> workload == FRAME)?(threads):(1);
+  size_t per_thread, arena_size;
+  per_thread = (OPERATIONS / TABLE_SIZE) *
+    ((m -> sizes == fixed_sizes)?(table_sum[0]):(table_sum[1])) +
+    OPERATIONS * (m -> alignment + 2 * sizeof(void *));
+  per_thread += per_thread / 8 + 2 * BUFFER_SIZE; // Space lost in buffers
+  arena_size = (m -> workload == FRAME)?(per_thread):(threads * per_thread);
+  for(i = 0; i < number_of_arenas; i ++)
+    m -> arena[i] = (m -> allocator == MALLOC)?(NULL):
+      (_Wcreate_arena_flags(arena_size, W_PREFAULT));
+  m -> start = 0;
+  for(i = 0; i < threads; i ++){
+    data[i].measure = m;
+    data[i].id = i;
+    data[i].out = (void **) malloc(OPERATIONS * sizeof(void *));
+  }
+  {
+#if defined(_WIN32)
+    HANDLE thread[MAX_THREADS];
+    for(i = 0; i < threads; i ++)
+      thread[i] = CreateThread(NULL, 0, thread_function, &(data[i]), 0, NULL);
+    counters_start(&counters);
+    begin = now();
+    __atomic_store_n(&(m -> start), 1, __ATOMIC_RELEASE);
+    WaitForMultipleObjects(threads, thread, TRUE, INFINITE);
+    end = now();
+    counters_stop(&counters);
+    for(i = 0; i < threads; i ++)
+      CloseHandle(thread[i]);
+#else
+    pthread_t thread[MAX_THREADS];
+    for(i = 0; i < threads; i ++)
+      pthread_create(&(thread[i]), NULL, thread_function, &(data[i]));
+    counters_start(&counters);
+    begin = now();
+    __atomic_store_n(&(m -> start), 1, __ATOMIC_RELEASE);
+    for(i = 0; i < threads; i ++)
+      pthread_join(thread[i], NULL);
+    end = now();
+    counters_stop(&counters);
+#endif
+  }
+  for(i = 0; i < NUMBER_OF_COUNTERS; i ++)
+    counter_sum[i] += counters.value[i];
+  for(i = 0; i < threads; i ++){
+    if(m -> allocator == MALLOC && m -> workload == ALLOC){
+      size_t j;
+      for(j = 0; j < OPERATIONS; j ++)
+        free(data[i].out[j]);
+    }
+    free(data[i].out);
+  }
+  for(i = 0; i < number_of_arenas; i ++)
+    if(m -> arena[i] != NULL){
+      _Wtrash(m -> arena[i], 0);
+      _Wtrash(m -> arena[i], 1);
+      _Wdestroy_arena(m -> arena[i]);
+    }
+  return end - begin;
+}
+
+static int compare_doubles(const void *a, const void *b){
+  double d1 = *(const double *) a, d2 = *(const double *) b;
+  return (d1 < d2)?(-1):((d1 > d2)?(1):(0));
+}
+
+static void measure(struct measure *m, unsigned threads){
+  double t[REPETITIONS];
+  size_t operations = (size_t) threads *
+    ((m -> workload == FRAME)?(FRAMES * FRAME_ALLOCS):(OPERATIONS));
+  int i;
+  run(m, threads); // Warmup
+  memset(counter_sum, 0, sizeof(counter_sum));
+  for(i = 0; i < REPETITIONS; i ++)
+    t[i] = run(m, threads);
+  for(i = 0; i < NUMBER_OF_COUNTERS; i ++)
+    counters.value[i] = counter_sum[i] / REPETITIONS;
+  qsort(t, REPETITIONS, sizeof(double), compare_doubles);
+  printf("%s,%s,%u,%s,%s,%u,%zu,%.9f,%.0f", workload_name[m -> workload],
+         allocator_name[m -> allocator], threads,
+         (m -> sizes == fixed_sizes)?("fixed"):("mixed"),
+         (m -> allocator == MALLOC)?("-"):(stack_name[m -> stack]),
+         m -> alignment, operations, t[REPETITIONS / 2],
+         operations / t[REPETITIONS / 2]);
+  counters_print(stdout, &counters, operations);
+  printf("\n");
+  fflush(stdout);
+}
+
+int main(int argc, char **argv){
+  unsigned alignments[3] = {0, 16, 64};
+  unsigned max_threads = number_of_cores(), threads;
+  struct measure m;
+  int s, stack, alignment, allocator;
+  if(argc > 1)
+    max_threads = atoi(argv[1]);
+  if(max_threads < 1)
+    max_threads = 1;
+  if(max_threads > MAX_THREADS)
+    max_threads = MAX_THREADS;
+  init_tables();
+  counters_open(&counters);
+  printf("workload,allocator,threads,sizes,stack,alignment,operations,"
+         "seconds,operations_per_second");
+  counters_print_header(stdout);
+  printf("\n");
+  for(threads = 1; threads <= max_threads;
+      threads = (threads * 2 > max_threads && threads != max_threads)?
+        (max_threads):(threads * 2)){
+    m.workload = ALLOC;
+    for(s = 0; s < 2; s ++){
+      m.sizes = (s)?(mixed_sizes):(fixed_sizes);
+      for(allocator = WALLOC; allocator <= MALLOC; allocator ++){
+        m.allocator = (enum allocator) allocator;
+        for(stack = 0; stack < 3; stack ++){
+          if(allocator == MALLOC && stack > 0)
+            break;
+          if(allocator == WBUFFER && stack == 2)
+            break;
+          for(alignment = 0; alignment < 3; alignment ++){
+            if(allocator == MALLOC && alignment > 0)
+              break;
+            m.stack = stack;
+            m.alignment = alignments[alignment];
+            measure(&m, threads);
+          }
+        }
+      }
+    }
+    m.workload = FRAME;
+    m.sizes = mixed_sizes;
+    m.stack = 0;
+    m.alignment = 0;
+    for(allocator = WALLOC; allocator <= MALLOC; allocator ++){
+      m.allocator = (enum allocator) allocator;
+      measure(&m, threads);
+    }
+  }
+  counters_close(&counters);
+  return 0;
+}
@@ -1,5 +1,5 @@
-/*39:*/
-#line 1090 "./weaver-memory-manager.tex"
+/*201:*/
+#line 5511 "./weaver-memory-manager.tex"
 
 /*7:*/
 #line 314 "./weaver-memory-manager.tex"
@@ -8,50 +8,105 @@
 #include <sys/mman.h> 
 #endif
 /*:7*//*12:*/
-#line 392 "./weaver-memory-manager.tex"
+#line 397 "./weaver-memory-manager.tex"
 
 #if defined(_WIN32)
 #include <windows.h>   
 #include <memoryapi.h>  
 #endif
 /*:12*//*15:*/
-#line 446 "./weaver-memory-manager.tex"
+#line 451 "./weaver-memory-manager.tex"
 
 #if defined(__APPLE__) || defined(__unix__)
 #include <unistd.h> 
 #endif
 /*:15*//*17:*/
-#line 474 "./weaver-memory-manager.tex"
+#line 479 "./weaver-memory-manager.tex"
 
 #if defined(_WIN32)
 #include <windows.h>  
 #endif
 /*:17*//*19:*/
-#line 527 "./weaver-memory-manager.tex"
+#line 532 "./weaver-memory-manager.tex"
 
 #if defined(__unix__) || defined(__APPLE__)
 #include <pthread.h> 
 #endif
-/*:19*//*29:*/
-#line 784 "./weaver-memory-manager.tex"
+/*:19*//*33:*/
+#line 955 "./weaver-memory-manager.tex"
 
 #if defined(W_DEBUG_MEMORY)
 #include <stdio.h> 
 #endif
-/*:29*//*31:*/
-#line 826 "./weaver-memory-manager.tex"
+/*:33*//*35:*/
+#line 997 "./weaver-memory-manager.tex"
 
 #include <stdint.h> 
-/*:31*/
-#line 1091 "./weaver-memory-manager.tex"
+/*:35*//*125:*/
+#line 3544 "./weaver-memory-manager.tex"
+
+#include <string.h>  
+/*:125*//*146:*/
+#line 4089 "./weaver-memory-manager.tex"
+
+#if defined(W_LOCK_STATS) || defined(W_TRACE)
+#include <stddef.h>  
+#include <time.h>  
+#endif
+/*:146*//*152:*/
+#line 4381 "./weaver-memory-manager.tex"
+
+#if defined(W_TRACE)
+#include <stdio.h>  
+#endif
+/*:152*//*174:*/
+#line 4787 "./weaver-memory-manager.tex"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <errno.h>  
+#endif
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+#include <fcntl.h>  
+#include <sys/stat.h>  
+#endif
+#if defined(__linux__)
+#include <sys/syscall.h>  
+#endif
+#if defined(MAP_FIXED_NOREPLACE)
+#define W_MAP_FIXED_NOREPLACE MAP_FIXED_NOREPLACE
+#else
+#define W_MAP_FIXED_NOREPLACE 0
+#endif
+/*:174*//*178:*/
+#line 4861 "./weaver-memory-manager.tex"
+
+#define W_SIGNATURE (((size_t) 0x57454156) ^ (sizeof(struct arena_header) << 20))
+/*:178*/
+#line 5512 "./weaver-memory-manager.tex"
 
 #include "memory.h"
-/*25:*/
-#line 645 "./weaver-memory-manager.tex"
+/*29:*/
+#line 770 "./weaver-memory-manager.tex"
 
 struct arena_header{
+/*28:*/
+#line 761 "./weaver-memory-manager.tex"
+
+void*left_free,*right_free;
+size_t remaining_space;
+/*:28*//*55:*/
+#line 1592 "./weaver-memory-manager.tex"
+
+unsigned flags;
+/*:55*//*133:*/
+#line 3786 "./weaver-memory-manager.tex"
+
+size_t allocations,alignment_padding;
+/*:133*/
+#line 772 "./weaver-memory-manager.tex"
+
 /*20:*/
-#line 537 "./weaver-memory-manager.tex"
+#line 542 "./weaver-memory-manager.tex"
 
 #if defined(__unix__) || defined(__APPLE__)
 pthread_mutex_t mutex;
@@ -60,81 +115,276 @@ pthread_mutex_t mutex;
 CRITICAL_SECTION mutex;
 #endif
 /*:20*/
-#line 647 "./weaver-memory-manager.tex"
+#line 773 "./weaver-memory-manager.tex"
 
-void*left_free,*right_free;
 void*left_point,*right_point;
-size_t remaining_space,total_size,right_allocations,left_allocations;
-#if defined(W_DEBUG_MEMORY)
-size_t smallest_remaining_space;
+size_t total_size;
+/*45:*/
+#line 1359 "./weaver-memory-manager.tex"
+
+char padding1[64];
+size_t left_generation,right_generation;
+char padding2[64];
+/*:45*//*56:*/
+#line 1598 "./weaver-memory-manager.tex"
+
+size_t page_size;
+void*left_committed,*right_committed;
+/*:56*//*61:*/
+#line 1734 "./weaver-memory-manager.tex"
+
+void*left_chunk,*right_chunk,*chunk_cache;
+size_t cached_chunks;
+/*:61*//*72:*/
+#line 2014 "./weaver-memory-manager.tex"
+
+size_t trim_threshold;
+/*:72*//*101:*/
+#line 2886 "./weaver-memory-manager.tex"
+
+struct destructor*left_destructors,*right_destructors;
+/*:101*//*134:*/
+#line 3798 "./weaver-memory-manager.tex"
+
+size_t left_high_water,right_high_water;
+size_t memory_points,failed_allocations;
+/*:134*//*140:*/
+#line 3937 "./weaver-memory-manager.tex"
+
+#if defined(W_LOCK_STATS)
+size_t lock_acquisitions,contended_acquisitions;
+unsigned long long wait_time,longest_wait;
+int longest_wait_operation,longest_wait_side;
 #endif
+/*:140*//*167:*/
+#line 4612 "./weaver-memory-manager.tex"
+
+void*base;
+/*:167*//*176:*/
+#line 4849 "./weaver-memory-manager.tex"
+
+size_t signature;
+/*:176*//*188:*/
+#line 5149 "./weaver-memory-manager.tex"
+
+int snapshot_file;
+/*:188*/
+#line 776 "./weaver-memory-manager.tex"
+
 };
-/*:25*/
-#line 1093 "./weaver-memory-manager.tex"
+/*:29*/
+#line 5514 "./weaver-memory-manager.tex"
 
-/*36:*/
-#line 987 "./weaver-memory-manager.tex"
+/*41:*/
+#line 1205 "./weaver-memory-manager.tex"
 
 struct memory_point{
-size_t allocations;
+void*free;
 struct memory_point*last_memory_point;
+/*102:*/
+#line 2892 "./weaver-memory-manager.tex"
+
+struct destructor*destructors;
+/*:102*/
+#line 1209 "./weaver-memory-manager.tex"
+
 };
-/*:36*/
-#line 1094 "./weaver-memory-manager.tex"
+/*:41*/
+#line 5515 "./weaver-memory-manager.tex"
 
-/*27:*/
-#line 718 "./weaver-memory-manager.tex"
+/*60:*/
+#line 1708 "./weaver-memory-manager.tex"
 
-void*_Wcreate_arena(size_t t){
-bool error= false;
-void*arena;
-size_t p,M,header_size= sizeof(struct arena_header);
+struct chunk_header{
+void*previous;
+size_t size;
+char*free;
+};
+/*:60*/
+#line 5516 "./weaver-memory-manager.tex"
 
-/*13:*/
-#line 420 "./weaver-memory-manager.tex"
+/*100:*/
+#line 2872 "./weaver-memory-manager.tex"
 
-#if defined(__unix__)
-p= sysconf(_SC_PAGESIZE);
-#endif
-/*:13*//*14:*/
-#line 435 "./weaver-memory-manager.tex"
+struct destructor{
+void(*function)(void*);
+void*object;
+struct destructor*previous;
+};
+/*:100*/
+#line 5517 "./weaver-memory-manager.tex"
 
-#if defined(__APPLE__)
-p= getpagesize();
+/*116:*/
+#line 3238 "./weaver-memory-manager.tex"
+
+struct pool_class{
+size_t size;
+char*begin,*end,*next;
+void*free;
+char padding[64];
+void*remote_free;
+};
+struct pool_header{
+unsigned number_of_classes;
+struct pool_class classes[];
+};
+/*:116*/
+#line 5518 "./weaver-memory-manager.tex"
+
+/*25:*/
+#line 646 "./weaver-memory-manager.tex"
+
+static void*load_pointer(void**p){
+#if defined(__unix__) || defined(__APPLE__)
+return __atomic_load_n(p,__ATOMIC_ACQUIRE);
 #endif
-/*:14*//*16:*/
-#line 459 "./weaver-memory-manager.tex"
+#if defined(_WIN32)
+return InterlockedCompareExchangePointer(p,NULL,NULL);
+#endif
+}
+static size_t load_size(size_t*p){
+#if defined(__unix__) || defined(__APPLE__)
+return __atomic_load_n(p,__ATOMIC_ACQUIRE);
+#endif
+#if defined(_WIN64)
+return(size_t)InterlockedCompareExchange64((LONG64 volatile*)p,0,0);
+#elif defined(_WIN32)
+return(size_t)InterlockedCompareExchange((LONG volatile*)p,0,0);
+#endif
+}
+/*:25*//*26:*/
+#line 673 "./weaver-memory-manager.tex"
 
+static bool cas_pointer(void**p,void*expected,void*desired){
+#if defined(__unix__) || defined(__APPLE__)
+return __atomic_compare_exchange_n(p,&expected,desired,false,
+__ATOMIC_ACQ_REL,__ATOMIC_ACQUIRE);
+#endif
 #if defined(_WIN32)
-{
-SYSTEM_INFO info;
-GetSystemInfo(&info);
-p= info.dwPageSize;
+return(InterlockedCompareExchangePointer(p,desired,expected)==expected);
+#endif
 }
+static bool cas_size(size_t*p,size_t expected,size_t desired){
+#if defined(__unix__) || defined(__APPLE__)
+return __atomic_compare_exchange_n(p,&expected,desired,false,
+__ATOMIC_ACQ_REL,__ATOMIC_ACQUIRE);
 #endif
-/*:16*//*18:*/
-#line 491 "./weaver-memory-manager.tex"
+#if defined(_WIN64)
+return(InterlockedCompareExchange64((LONG64 volatile*)p,(LONG64)desired,
+(LONG64)expected)==(LONG64)expected);
+#elif defined(_WIN32)
+return(InterlockedCompareExchange((LONG volatile*)p,(LONG)desired,
+(LONG)expected)==(LONG)expected);
+#endif
+}
+/*:26*//*27:*/
+#line 703 "./weaver-memory-manager.tex"
+
+static void add_size(size_t*p,size_t value){
+#if defined(__unix__) || defined(__APPLE__)
+__atomic_fetch_add(p,value,__ATOMIC_ACQ_REL);
+#endif
+#if defined(_WIN64)
+InterlockedExchangeAdd64((LONG64 volatile*)p,(LONG64)value);
+#elif defined(_WIN32)
+InterlockedExchangeAdd((LONG volatile*)p,(LONG)value);
+#endif
+}
+static void*exchange_pointer(void**p,void*desired){
+#if defined(__unix__) || defined(__APPLE__)
+return __atomic_exchange_n(p,desired,__ATOMIC_ACQ_REL);
+#endif
+#if defined(_WIN32)
+return InterlockedExchangePointer(p,desired);
+#endif
+}
+/*:27*/
+#line 5519 "./weaver-memory-manager.tex"
 
+/*53:*/
+#line 1553 "./weaver-memory-manager.tex"
+
+static bool commit_memory(void*p,size_t size){
 #if defined(__EMSCRIPTEN__)
-p= 64*1024;
+return true;
 #endif
-/*:18*/
-#line 724 "./weaver-memory-manager.tex"
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+return(mprotect(p,size,PROT_READ|PROT_WRITE)==0);
+#endif
+#if defined(_WIN32)
+return(VirtualAlloc(p,size,MEM_COMMIT,PAGE_READWRITE)!=NULL);
+#endif
+}
+/*:53*//*58:*/
+#line 1642 "./weaver-memory-manager.tex"
 
+static bool grow_stack(struct arena_header*header,int right,
+char*limit){
+char*arena= (char*)header,*committed,*new_committed;
+size_t block= 16*header->page_size,position;
+if(right){
+committed= (char*)load_pointer(&(header->right_committed));
+while(limit<committed){
+position= ((limit-arena)/block)*block;
+new_committed= arena+position;
+if(!commit_memory(new_committed,committed-new_committed))
+return false;
+if(cas_pointer(&(header->right_committed),committed,new_committed))
+break;
+committed= (char*)load_pointer(&(header->right_committed));
+}
+}
+else{
+committed= (char*)load_pointer(&(header->left_committed));
+while(limit> committed){
+position= (((limit-arena-1)/block)+1)*block;
+if(position> header->total_size)
+position= header->total_size;
+new_committed= arena+position;
+if(!commit_memory(committed,new_committed-committed))
+return false;
+if(cas_pointer(&(header->left_committed),committed,new_committed))
+break;
+committed= (char*)load_pointer(&(header->left_committed));
+}
+}
+return true;
+}
+/*:58*/
+#line 5520 "./weaver-memory-manager.tex"
 
-M= (((t-1)/p)+1)*p;
-if(M<header_size)
-M= (((header_size-1)/p)+1)*p;
+/*67:*/
+#line 1840 "./weaver-memory-manager.tex"
 
+static struct chunk_header*new_chunk(struct arena_header*header,
+size_t t){
+struct chunk_header*chunk= (struct chunk_header*)header->chunk_cache;
+void**previous= &(header->chunk_cache);
+t+= sizeof(struct chunk_header);
+while(chunk!=NULL&&chunk->size<t){
+previous= &(chunk->previous);
+chunk= (struct chunk_header*)chunk->previous;
+}
+if(chunk!=NULL){
+*previous= chunk->previous;
+header->cached_chunks--;
+}
+else{
+void*arena;
+size_t M= header->total_size;
+if(M<t)
+M= (((t-1)/header->page_size)+1)*header->page_size;
 /*8:*/
 #line 327 "./weaver-memory-manager.tex"
 
 #if defined(__EMSCRIPTEN__) || defined(__unix__) || defined(__APPLE__)
 arena= mmap(NULL,M,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANON,
 -1,0);
+if(arena==MAP_FAILED)
+arena= NULL;
 #endif
 /*:8*//*10:*/
-#line 363 "./weaver-memory-manager.tex"
+#line 368 "./weaver-memory-manager.tex"
 
 #if defined(_WIN32)
 {
@@ -149,279 +399,4146 @@ CloseHandle(handle);
 }
 #endif
 /*:10*/
-#line 730 "./weaver-memory-manager.tex"
+#line 1859 "./weaver-memory-manager.tex"
 
+if(arena==NULL)
+return NULL;
+chunk= (struct chunk_header*)arena;
+chunk->size= M;
+}
+chunk->free= ((char*)chunk)+sizeof(struct chunk_header);
+return chunk;
+}
+/*:67*//*68:*/
+#line 1875 "./weaver-memory-manager.tex"
 
-/*26:*/
-#line 670 "./weaver-memory-manager.tex"
+static void unmap_chunk(struct chunk_header*chunk){
+void*arena= chunk;
+size_t M= chunk->size;
+/*9:*/
+#line 349 "./weaver-memory-manager.tex"
 
-{
-struct arena_header*header= (struct arena_header*)arena;
-header->right_free= ((char*)header)+M-1;
-header->left_free= ((char*)header)+sizeof(struct arena_header);
-header->remaining_space= M-sizeof(struct arena_header);
-header->right_allocations= 0;
-header->left_allocations= 0;
-header->total_size= M;
-header->left_point= NULL;
-header->right_point= NULL;
-#if defined(W_DEBUG_MEMORY)
-header->smallest_remaining_space= header->remaining_space;
+#if defined(__EMSCRIPTEN__) || defined(__unix__) || defined(__APPLE__)
+munmap(arena,M);
 #endif
-{
-void*mutex= &(header->mutex);
-/*21:*/
-#line 555 "./weaver-memory-manager.tex"
+/*:9*//*11:*/
+#line 387 "./weaver-memory-manager.tex"
 
-#if defined(__unix__) || defined(__APPLE__)
-error= pthread_mutex_init((pthread_mutex_t*)mutex,NULL);
-#endif
 #if defined(_WIN32)
-InitializeCriticalSection((CRITICAL_SECTION*)mutex);
+UnmapViewOfFile(arena);
 #endif
-/*:21*/
-#line 686 "./weaver-memory-manager.tex"
+/*:11*/
+#line 1879 "./weaver-memory-manager.tex"
 
 }
+static void release_chunk(struct arena_header*header,
+struct chunk_header*chunk){
+if(header->cached_chunks<4){
+chunk->previous= header->chunk_cache;
+header->chunk_cache= chunk;
+header->cached_chunks++;
 }
-/*:26*/
-#line 732 "./weaver-memory-manager.tex"
-
-
-if(error)return NULL;
-return arena;
+else
+unmap_chunk(chunk);
 }
-/*:27*/
-#line 1095 "./weaver-memory-manager.tex"
-
-/*28:*/
-#line 758 "./weaver-memory-manager.tex"
+/*:68*/
+#line 5521 "./weaver-memory-manager.tex"
 
-bool _Wdestroy_arena(void*arena){
-struct arena_header*header= (struct arena_header*)arena;
-void*mutex= (void*)&(header->mutex);
-size_t M= header->total_size;
-bool ret= true;
-/*22:*/
-#line 569 "./weaver-memory-manager.tex"
+/*71:*/
+#line 1978 "./weaver-memory-manager.tex"
 
+static void release_pages(struct arena_header*header,char*begin,
+char*end){
+char*arena= (char*)header;
+size_t p= header->page_size,first,last;
+first= (((begin-arena)+p-1)/p)*p;
+last= ((end-arena)/p)*p;
+if(last<=first)
+return;
 #if defined(__unix__) || defined(__APPLE__)
-pthread_mutex_destroy((pthread_mutex_t*)mutex);
+#if defined(__linux__) || !defined(MADV_FREE)
+madvise(arena+first,last-first,MADV_DONTNEED);
+#else
+madvise(arena+first,last-first,MADV_FREE);
+#endif
 #endif
 #if defined(_WIN32)
-DeleteCriticalSection((CRITICAL_SECTION*)mutex);
+VirtualAlloc(arena+first,last-first,MEM_RESET,PAGE_READWRITE);
 #endif
-/*:22*/
-#line 764 "./weaver-memory-manager.tex"
+}
+/*:71*/
+#line 5522 "./weaver-memory-manager.tex"
 
-if(header->total_size!=header->remaining_space+
-sizeof(struct arena_header))
-ret= false;
-#if defined(W_DEBUG_MEMORY)
-printf("Unused memory: %zu/%zu (%f%%)\n",
-header->smallest_remaining_space,header->total_size,
-100.0*
-((float)header->smallest_remaining_space)/header->total_size);
-#endif
-/*9:*/
-#line 344 "./weaver-memory-manager.tex"
+/*86:*/
+#line 2322 "./weaver-memory-manager.tex"
 
-#if defined(__EMSCRIPTEN__) || defined(__unix__) || defined(__APPLE__)
-munmap(arena,M);
+struct prefault_region{
+char*begin;
+size_t size,page;
+};
+static void touch_pages(struct prefault_region*region){
+size_t i;
+for(i= 0;i<region->size;i+= region->page)
+((volatile char*)region->begin)[i]= 0;
+}
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+static void*prefault_thread(void*region){
+touch_pages((struct prefault_region*)region);
+return NULL;
+}
 #endif
-/*:9*//*11:*/
-#line 382 "./weaver-memory-manager.tex"
-
 #if defined(_WIN32)
-UnmapViewOfFile(arena);
-#endif
-/*:11*/
-#line 774 "./weaver-memory-manager.tex"
-
-return ret;
+static DWORD WINAPI prefault_thread(LPVOID region){
+touch_pages((struct prefault_region*)region);
+return 0;
 }
-/*:28*/
-#line 1096 "./weaver-memory-manager.tex"
-
-/*34:*/
-#line 921 "./weaver-memory-manager.tex"
+#endif
+/*:86*//*87:*/
+#line 2354 "./weaver-memory-manager.tex"
 
-void*_Walloc(void*arena,unsigned a,int right,size_t t){
-struct arena_header*header= (struct arena_header*)arena;
-void*mutex= (void*)&(header->mutex);
-void*p= NULL;
-/*23:*/
-#line 582 "./weaver-memory-manager.tex"
+static void prefault(char*arena,size_t M,size_t p){
+struct prefault_region regions[16];
+size_t i,n= 1,block;
+/*88:*/
+#line 2380 "./weaver-memory-manager.tex"
 
-#if defined(__unix__) || defined(__APPLE__)
-pthread_mutex_lock((pthread_mutex_t*)mutex);
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+{
+long cpus= sysconf(_SC_NPROCESSORS_ONLN);
+if(cpus> 1)
+n= cpus;
+}
 #endif
 #if defined(_WIN32)
-EnterCriticalSection((CRITICAL_SECTION*)mutex);
+{
+SYSTEM_INFO info;
+GetSystemInfo(&info);
+n= info.dwNumberOfProcessors;
+}
 #endif
-/*:23*/
-#line 926 "./weaver-memory-manager.tex"
+/*:88*/
+#line 2358 "./weaver-memory-manager.tex"
 
-/*33:*/
-#line 879 "./weaver-memory-manager.tex"
+if(n> 16)
+n= 16;
+if(n> M/(64*1024*1024))
+n= M/(64*1024*1024);
+if(n<1)
+n= 1;
+block= ((M/p)/n)*p;
+for(i= 0;i<n;i++){
+regions[i].begin= arena+i*block;
+regions[i].size= (i==n-1)?(M-i*block):(block);
+regions[i].page= p;
+}
+/*89:*/
+#line 2403 "./weaver-memory-manager.tex"
 
+#if defined(__EMSCRIPTEN__)
+for(i= 0;i<n;i++)
+touch_pages(&regions[i]);
+#endif
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
 {
-int offset;
-struct arena_header*head= (struct arena_header*)arena;
-if(head->remaining_space>=t+((a==0)?(0):(a-1))){
-if(right){
-p= ((char*)head->right_free)-t+1;
-/*32:*/
-#line 839 "./weaver-memory-manager.tex"
-
-offset= 0;
-if(a> 1){
-void*new_p= (void*)(((uintptr_t)p)&(~((uintptr_t)a-1)));
-offset= ((char*)p)-((char*)new_p);
-p= new_p;
+pthread_t threads[16];
+bool created[16];
+for(i= 1;i<n;i++)
+created[i]= (pthread_create(&threads[i],NULL,prefault_thread,
+&regions[i])==0);
+touch_pages(&regions[0]);
+for(i= 1;i<n;i++){
+if(created[i])
+pthread_join(threads[i],NULL);
+else
+touch_pages(&regions[i]);
 }
-/*:32*/
-#line 886 "./weaver-memory-manager.tex"
-
-head->right_free= (char*)p-1;
-head->right_allocations+= (t+offset);
 }
-else{
-p= head->left_free;
-/*30:*/
-#line 810 "./weaver-memory-manager.tex"
+#endif
+#if defined(_WIN32)
+{
+HANDLE threads[16];
+for(i= 1;i<n;i++)
+threads[i]= CreateThread(NULL,0,prefault_thread,&regions[i],0,NULL);
+touch_pages(&regions[0]);
+for(i= 1;i<n;i++){
+if(threads[i]!=NULL){
+WaitForSingleObject(threads[i],INFINITE);
+CloseHandle(threads[i]);
+}
+else
+touch_pages(&regions[i]);
+}
+}
+#endif
+/*:89*/
+#line 2371 "./weaver-memory-manager.tex"
 
-offset= 0;
-if(a> 1){
-void*new_p= ((char*)p)+(a-1);
-new_p= (void*)(((uintptr_t)new_p)&(~((uintptr_t)a-1)));
-offset= ((char*)new_p)-((char*)p);
-p= new_p;
 }
-/*:30*/
-#line 892 "./weaver-memory-manager.tex"
+/*:87*/
+#line 5523 "./weaver-memory-manager.tex"
+
+/*137:*/
+#line 3835 "./weaver-memory-manager.tex"
 
-head->left_free= (char*)p+t;
-head->left_allocations+= (t+offset);
+static size_t record_high_water(struct arena_header*header,int right){
+char*arena= (char*)header;
+struct chunk_header*chunk;
+size_t used,old,*high_water;
+if(right){
+used= (arena+header->total_size-1)-
+(char*)load_pointer(&(header->right_free));
+chunk= (struct chunk_header*)load_pointer(&(header->right_chunk));
+high_water= &(header->right_high_water);
 }
-head->remaining_space-= (t+offset);
-#if defined(W_DEBUG_MEMORY)
-if(head->remaining_space<head->smallest_remaining_space)
-head->smallest_remaining_space= head->remaining_space;
-#endif
+else{
+used= ((char*)load_pointer(&(header->left_free)))-
+(arena+sizeof(struct arena_header));
+chunk= (struct chunk_header*)load_pointer(&(header->left_chunk));
+high_water= &(header->left_high_water);
 }
+for(;chunk!=NULL;chunk= (struct chunk_header*)chunk->previous)
+used+= chunk->free-(((char*)chunk)+sizeof(struct chunk_header));
+do{
+old= load_size(high_water);
+}while(used> old&&!cas_size(high_water,old,used));
+return used;
 }
-/*:33*/
-#line 927 "./weaver-memory-manager.tex"
+/*:137*//*144:*/
+#line 4001 "./weaver-memory-manager.tex"
 
-/*24:*/
-#line 596 "./weaver-memory-manager.tex"
+#if defined(W_LOCK_STATS)
+static const char*const lock_operations[]= {
+"_Walloc","_Walloc_batch","_Wbegin_frame","_Wcommit",
+"_Wdestroy_frame_ring","_Wget_lock_stats","_Wmempoint",
+"_Wregister_destructor","_Wrestore","_Wset_mark",
+"_Wset_trim_threshold","_Wsnapshot","_Wsync_file_arena","_Wtrash",
+"_Wtrash_to","_Wtrim",NULL
+};
+static int lock_operation(const char*name){
+int i;
+for(i= 0;lock_operations[i]!=NULL;i++)
+if(!strcmp(lock_operations[i],name))
+return i;
+return-1;
+}
+#endif
+/*:144*//*145:*/
+#line 4028 "./weaver-memory-manager.tex"
 
+#if defined(W_LOCK_STATS) || defined(W_TRACE)
+static unsigned long long monotonic_time(void){
 #if defined(__unix__) || defined(__APPLE__)
-pthread_mutex_unlock((pthread_mutex_t*)mutex);
+struct timespec t;
+clock_gettime(CLOCK_MONOTONIC,&t);
+return((unsigned long long)t.tv_sec)*1000000000ull+t.tv_nsec;
 #endif
 #if defined(_WIN32)
-LeaveCriticalSection((CRITICAL_SECTION*)mutex);
+LARGE_INTEGER t,frequency;
+QueryPerformanceCounter(&t);
+QueryPerformanceFrequency(&frequency);
+return(unsigned long long)
+(t.QuadPart*(1000000000.0/frequency.QuadPart));
 #endif
-/*:24*/
-#line 928 "./weaver-memory-manager.tex"
-
-return p;
 }
-/*:34*/
-#line 1097 "./weaver-memory-manager.tex"
+#endif
+#if defined(W_LOCK_STATS)
+static void lock_mutex(void*mutex,const char*operation,int right){
+struct arena_header*header= (struct arena_header*)
+(((char*)mutex)-offsetof(struct arena_header,mutex));
+unsigned long long begin,wait;
+#if defined(__unix__) || defined(__APPLE__)
+int status= pthread_mutex_trylock((pthread_mutex_t*)mutex);
+if(status==0||status==EOWNERDEAD){
+if(status==EOWNERDEAD){
+/*171:*/
+#line 4716 "./weaver-memory-manager.tex"
 
-/*37:*/
-#line 1005 "./weaver-memory-manager.tex"
+#if defined(__linux__)
+pthread_mutex_consistent((pthread_mutex_t*)mutex);
+#endif
+/*:171*/
+#line 4054 "./weaver-memory-manager.tex"
 
-bool _Wmempoint(void*arena,unsigned a,int right){
-struct arena_header*header= (struct arena_header*)arena;
-void*mutex= (void*)&(header->mutex);
-char*p= NULL;
-struct memory_point*point;
-size_t allocations,t= sizeof(struct memory_point);
-/*23:*/
-#line 582 "./weaver-memory-manager.tex"
+}
+header->lock_acquisitions++;
+return;
+}
+begin= monotonic_time();
+if(pthread_mutex_lock((pthread_mutex_t*)mutex)==EOWNERDEAD){
+/*171:*/
+#line 4716 "./weaver-memory-manager.tex"
 
-#if defined(__unix__) || defined(__APPLE__)
-pthread_mutex_lock((pthread_mutex_t*)mutex);
+#if defined(__linux__)
+pthread_mutex_consistent((pthread_mutex_t*)mutex);
 #endif
-#if defined(_WIN32)
+/*:171*/
+#line 4061 "./weaver-memory-manager.tex"
+
+}
+#endif
+#if defined(_WIN32)
+if(TryEnterCriticalSection((CRITICAL_SECTION*)mutex)){
+header->lock_acquisitions++;
+return;
+}
+begin= monotonic_time();
+EnterCriticalSection((CRITICAL_SECTION*)mutex);
+#endif
+wait= monotonic_time()-begin;
+header->lock_acquisitions++;
+header->contended_acquisitions++;
+header->wait_time+= wait;
+if(wait>=header->longest_wait){
+header->longest_wait= wait;
+header->longest_wait_operation= lock_operation(operation);
+header->longest_wait_side= right;
+}
+}
+#endif
+/*:145*//*149:*/
+#line 4210 "./weaver-memory-manager.tex"
+
+#if defined(W_TRACE)
+#if defined(_MSC_VER)
+#define W_THREAD_LOCAL __declspec(thread)
+#else
+#define W_THREAD_LOCAL _Thread_local
+#endif
+#define W_TRACE_BUFFER 1024
+static FILE*trace_file= NULL;
+static uint32_t trace_threads= 0;
+#if defined(__unix__) || defined(__APPLE__)
+static pthread_mutex_t trace_mutex= PTHREAD_MUTEX_INITIALIZER;
+#endif
+#if defined(_WIN32)
+static SRWLOCK trace_mutex= SRWLOCK_INIT;
+#endif
+struct trace_buffer{
+struct _Wtrace_event event[W_TRACE_BUFFER];
+unsigned count;
+uint32_t thread,sequence;
+bool in_use;
+struct trace_buffer*next;
+};
+static struct trace_buffer*trace_buffers= NULL;
+static W_THREAD_LOCAL struct trace_buffer*trace_buffer= NULL;
+#if defined(__unix__) || defined(__APPLE__)
+static pthread_key_t trace_key;
+#endif
+#if defined(_WIN32)
+static DWORD trace_key;
+#endif
+static bool trace_key_created= false;
+/*:149*//*150:*/
+#line 4250 "./weaver-memory-manager.tex"
+
+static void lock_trace(void){
+#if defined(__unix__) || defined(__APPLE__)
+pthread_mutex_lock(&trace_mutex);
+#endif
+#if defined(_WIN32)
+AcquireSRWLockExclusive(&trace_mutex);
+#endif
+}
+static void unlock_trace(void){
+#if defined(__unix__) || defined(__APPLE__)
+pthread_mutex_unlock(&trace_mutex);
+#endif
+#if defined(_WIN32)
+ReleaseSRWLockExclusive(&trace_mutex);
+#endif
+}
+static void write_trace_buffer(struct trace_buffer*buffer){
+if(trace_file!=NULL&&buffer->count> 0)
+fwrite(buffer->event,sizeof(struct _Wtrace_event),
+buffer->count,trace_file);
+buffer->count= 0;
+}
+static void flush_trace_buffer(void){
+if(trace_buffer==NULL)
+return;
+lock_trace();
+write_trace_buffer(trace_buffer);
+unlock_trace();
+}
+/*151:*/
+#line 4319 "./weaver-memory-manager.tex"
+
+#if defined(__unix__) || defined(__APPLE__)
+static void release_trace_buffer(void*buffer){
+#endif
+#if defined(_WIN32)
+static void WINAPI release_trace_buffer(void*buffer){
+#endif
+if(buffer==NULL)
+return;
+lock_trace();
+write_trace_buffer((struct trace_buffer*)buffer);
+((struct trace_buffer*)buffer)->in_use= false;
+unlock_trace();
+}
+static bool acquire_trace_buffer(void){
+struct trace_buffer*buffer;
+lock_trace();
+if(!trace_key_created){
+#if defined(__unix__) || defined(__APPLE__)
+trace_key_created= (pthread_key_create(&trace_key,
+release_trace_buffer)==0);
+#endif
+#if defined(_WIN32)
+trace_key= FlsAlloc(release_trace_buffer);
+trace_key_created= (trace_key!=FLS_OUT_OF_INDEXES);
+#endif
+}
+for(buffer= trace_buffers;buffer!=NULL;buffer= buffer->next)
+if(!buffer->in_use)
+break;
+if(buffer==NULL){
+buffer= (struct trace_buffer*)malloc(sizeof(struct trace_buffer));
+if(buffer!=NULL){
+buffer->next= trace_buffers;
+trace_buffers= buffer;
+}
+}
+if(buffer!=NULL){
+buffer->count= 0;
+buffer->sequence= 0;
+buffer->thread= ++trace_threads;
+buffer->in_use= true;
+if(trace_key_created){
+#if defined(__unix__) || defined(__APPLE__)
+pthread_setspecific(trace_key,buffer);
+#endif
+#if defined(_WIN32)
+FlsSetValue(trace_key,buffer);
+#endif
+}
+}
+unlock_trace();
+trace_buffer= buffer;
+return(buffer!=NULL);
+}
+/*:151*/
+#line 4280 "./weaver-memory-manager.tex"
+
+static struct _Wtrace_event*trace_event(unsigned type,void*arena,
+int right,size_t size,
+unsigned alignment,void*result){
+struct _Wtrace_event*event;
+if(load_pointer((void**)&trace_file)==NULL)
+return NULL;
+if(trace_buffer==NULL&&!acquire_trace_buffer())
+return NULL;
+if(trace_buffer->count==W_TRACE_BUFFER)
+flush_trace_buffer();
+event= &(trace_buffer->event[trace_buffer->count]);
+event->time= monotonic_time();
+event->arena= (uint64_t)(uintptr_t)arena;
+event->size= size;
+event->offset= (result==NULL)?(UINT64_MAX):
+((uint64_t)(((char*)result)-((char*)arena)));
+event->previous_size= 0;
+event->thread= trace_buffer->thread;
+event->sequence= trace_buffer->sequence++;
+event->alignment= alignment;
+event->type= type;
+event->right= (right!=0);
+trace_buffer->count++;
+return event;
+}
+#endif
+/*:150*//*159:*/
+#line 4495 "./weaver-memory-manager.tex"
+
+#if defined(W_TRACE)
+static void trace_batch(void*arena,int right,size_t count,
+const size_t*sizes,const unsigned*alignments,
+void**out){
+struct _Wtrace_event*event;
+uint64_t time= 0;
+size_t i;
+for(i= 0;i<count;i++){
+event= trace_event(W_TRACE_BATCH,arena,right,sizes[i],
+alignments[i],out[i]);
+if(event==NULL)
+return;
+if(i==0){
+time= event->time;
+event->previous_size= count;
+}
+else
+event->time= time;
+}
+}
+#endif
+/*:159*/
+#line 5524 "./weaver-memory-manager.tex"
+
+/*191:*/
+#line 5185 "./weaver-memory-manager.tex"
+
+#if defined(__linux__)
+static bool discard_pages(int fd,char*arena,char*begin,char*end,
+bool save){
+size_t size= end-begin;
+if(save&&pwrite(fd,begin,size,begin-arena)!=(ssize_t)size)
+return false;
+return(madvise(begin,size,MADV_DONTNEED)==0);
+}
+/*:191*//*192:*/
+#line 5203 "./weaver-memory-manager.tex"
+
+static bool discard_private_pages(struct arena_header*header,bool save){
+uint64_t entries[512];
+char*arena= (char*)header,*run= NULL,*page;
+size_t p= header->page_size,pages= header->total_size/p,i,j,n;
+int fd= header->snapshot_file;
+bool ret= true;
+int pagemap= open("/proc/self/pagemap",O_RDONLY);
+if(pagemap==-1)
+return discard_pages(fd,arena,arena,arena+pages*p,save);
+for(i= 0;i<pages&&ret;i+= n){
+n= (pages-i<512)?(pages-i):(512);
+if(pread(pagemap,entries,n*sizeof(uint64_t),
+(((uintptr_t)arena)/p+i)*sizeof(uint64_t))!=
+(ssize_t)(n*sizeof(uint64_t))){
+ret= false;
+break;
+}
+for(j= 0;j<n&&ret;j++){
+bool private_page= ((entries[j]>>63)&1&&!((entries[j]>>61)&1))||
+((entries[j]>>62)&1);
+page= arena+(i+j)*p;
+if(private_page&&run==NULL)
+run= page;
+else if(!private_page&&run!=NULL){
+ret= discard_pages(fd,arena,run,page,save);
+run= NULL;
+}
+}
+}
+close(pagemap);
+if(ret&&run!=NULL)
+ret= discard_pages(fd,arena,run,arena+pages*p,save);
+if(!ret)
+ret= discard_pages(fd,arena,arena,arena+pages*p,save);
+return ret;
+}
+#endif
+/*:192*/
+#line 5525 "./weaver-memory-manager.tex"
+
+/*199:*/
+#line 5436 "./weaver-memory-manager.tex"
+
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+static void*relocated(void*p,uintptr_t delta){
+return(p==NULL)?(NULL):((void*)(((uintptr_t)p)+delta));
+}
+/*:199*//*200:*/
+#line 5455 "./weaver-memory-manager.tex"
+
+static bool relocate_arena(struct arena_header*header){
+char*arena= (char*)header,*end= arena+header->total_size;
+uintptr_t delta= ((uintptr_t)arena)-(uintptr_t)header->base;
+struct memory_point*point,*previous;
+int right;
+for(right= 0;right<2;right++){
+previous= NULL;
+point= (struct memory_point*)
+relocated((right)?(header->right_point):(header->left_point),delta);
+while(point!=NULL){
+if((char*)point<arena+sizeof(struct arena_header)||
+((char*)point)+sizeof(struct memory_point)> end)
+return false;
+if(previous!=NULL&&
+((right&&point<=previous)||(!right&&point>=previous)))
+return false;
+previous= point;
+point= (struct memory_point*)
+relocated(point->last_memory_point,delta);
+}
+}
+for(right= 0;right<2;right++){
+point= (struct memory_point*)
+relocated((right)?(header->right_point):(header->left_point),delta);
+while(point!=NULL){
+previous= point;
+point= (struct memory_point*)
+relocated(point->last_memory_point,delta);
+previous->free= relocated(previous->free,delta);
+previous->last_memory_point= point;
+previous->destructors= (struct destructor*)
+relocated(previous->destructors,delta);
+}
+}
+header->left_free= relocated(header->left_free,delta);
+header->right_free= relocated(header->right_free,delta);
+header->left_committed= relocated(header->left_committed,delta);
+header->right_committed= relocated(header->right_committed,delta);
+header->left_point= relocated(header->left_point,delta);
+header->right_point= relocated(header->right_point,delta);
+header->left_destructors= relocated(header->left_destructors,delta);
+header->right_destructors= relocated(header->right_destructors,delta);
+header->base= arena;
+return true;
+}
+#endif
+/*:200*/
+#line 5526 "./weaver-memory-manager.tex"
+
+/*129:*/
+#line 3660 "./weaver-memory-manager.tex"
+
+static bool stale_mark(struct arena_header*header,
+struct _Wmark*mark){
+int right= mark->right;
+struct memory_point*point;
+struct destructor*d;
+struct chunk_header*chunk;
+char*mark_free= (char*)mark->free,*begin,*top;
+point= (right)?(header->right_point):(header->left_point);
+while(point!=NULL&&point!=mark->memory_point)
+point= point->last_memory_point;
+d= (right)?(header->right_destructors):(header->left_destructors);
+while(d!=NULL&&d!=mark->destructors)
+d= d->previous;
+if(point!=mark->memory_point||d!=mark->destructors)
+return true;
+if(/*63:*/
+#line 1755 "./weaver-memory-manager.tex"
+
+(!(header->flags&W_CHAINED)||
+load_pointer((right)?(&(header->right_chunk)):
+(&(header->left_chunk)))==NULL)
+/*:63*/
+#line 3676 "./weaver-memory-manager.tex"
+){
+if(right){
+begin= (char*)load_pointer(&(header->right_free));
+top= ((char*)header)+header->total_size-1;
+}
+else{
+begin= ((char*)header)+sizeof(struct arena_header);
+top= (char*)load_pointer(&(header->left_free));
+}
+return(mark_free<begin||mark_free> top);
+}
+chunk= (struct chunk_header*)((right)?(header->right_chunk):
+(header->left_chunk));
+return(mark_free>=((char*)chunk)+sizeof(struct chunk_header)&&
+mark_free<=((char*)chunk)+chunk->size&&
+mark_free> chunk->free);
+}
+/*:129*/
+#line 5527 "./weaver-memory-manager.tex"
+
+/*66:*/
+#line 1795 "./weaver-memory-manager.tex"
+
+static void*chunk_alloc(struct arena_header*header,unsigned a,
+int right,size_t t,void**old_free){
+void**current;
+struct chunk_header*chunk;
+char*p;
+int offset;
+current= (right)?(&(header->right_chunk)):(&(header->left_chunk));
+chunk= (struct chunk_header*)*current;
+if(chunk!=NULL){
+p= chunk->free;
+/*34:*/
+#line 981 "./weaver-memory-manager.tex"
+
+offset= 0;
+if(a> 1){
+void*new_p= ((char*)p)+(a-1);
+new_p= (void*)(((uintptr_t)new_p)&(~((uintptr_t)a-1)));
+offset= ((char*)new_p)-((char*)p);
+p= new_p;
+}
+/*:34*/
+#line 1806 "./weaver-memory-manager.tex"
+
+if(t+offset<=(size_t)(((char*)chunk)+chunk->size-
+chunk->free)){
+*old_free= chunk->free;
+chunk->free= p+t;
+add_size(&(header->alignment_padding),offset);
+return p;
+}
+}
+chunk= new_chunk(header,t+((a==0)?(0):(a-1)));
+if(chunk==NULL)
+return NULL;
+chunk->previous= *current;
+exchange_pointer(current,chunk);
+*old_free= chunk->free;
+p= chunk->free;
+/*34:*/
+#line 981 "./weaver-memory-manager.tex"
+
+offset= 0;
+if(a> 1){
+void*new_p= ((char*)p)+(a-1);
+new_p= (void*)(((uintptr_t)new_p)&(~((uintptr_t)a-1)));
+offset= ((char*)new_p)-((char*)p);
+p= new_p;
+}
+/*:34*/
+#line 1822 "./weaver-memory-manager.tex"
+
+chunk->free= p+t;
+add_size(&(header->alignment_padding),offset);
+return p;
+}
+/*:66*/
+#line 5528 "./weaver-memory-manager.tex"
+
+/*31:*/
+#line 844 "./weaver-memory-manager.tex"
+
+void*_Wcreate_arena_at(void*address,size_t t,unsigned flags){
+bool error= false;
+void*arena;
+int fd= -1;
+size_t p,M,small_page,header_size= sizeof(struct arena_header);
+/*186:*/
+#line 5115 "./weaver-memory-manager.tex"
+
+if(flags&W_SNAPSHOT){
+if(flags&(W_GROWABLE|W_CHAINED))
+return NULL;
+flags&= ~(W_HUGE_PAGES|W_PREFAULT|W_LOCKED);
+}
+/*:186*/
+#line 850 "./weaver-memory-manager.tex"
+
+
+/*13:*/
+#line 425 "./weaver-memory-manager.tex"
+
+#if defined(__unix__)
+p= sysconf(_SC_PAGESIZE);
+#endif
+/*:13*//*14:*/
+#line 440 "./weaver-memory-manager.tex"
+
+#if defined(__APPLE__)
+p= getpagesize();
+#endif
+/*:14*//*16:*/
+#line 464 "./weaver-memory-manager.tex"
+
+#if defined(_WIN32)
+{
+SYSTEM_INFO info;
+GetSystemInfo(&info);
+p= info.dwPageSize;
+}
+#endif
+/*:16*//*18:*/
+#line 496 "./weaver-memory-manager.tex"
+
+#if defined(__EMSCRIPTEN__)
+p= 64*1024;
+#endif
+/*:18*/
+#line 852 "./weaver-memory-manager.tex"
+
+small_page= p;
+if((flags&W_HUGE_PAGES)&&!(flags&W_GROWABLE)){
+/*80:*/
+#line 2143 "./weaver-memory-manager.tex"
+
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+p= 2*1024*1024;
+#endif
+#if defined(_WIN32)
+if(GetLargePageMinimum()> 0)
+p= GetLargePageMinimum();
+#endif
+/*:80*/
+#line 855 "./weaver-memory-manager.tex"
+
+}
+
+M= (((t-1)/p)+1)*p;
+if(M<header_size)
+M= (((header_size-1)/p)+1)*p;
+
+if(flags&W_GROWABLE){
+/*52:*/
+#line 1512 "./weaver-memory-manager.tex"
+
+{
+size_t header_pages= (((header_size-1)/p)+1)*p;
+#if defined(__EMSCRIPTEN__)
+/*8:*/
+#line 327 "./weaver-memory-manager.tex"
+
+#if defined(__EMSCRIPTEN__) || defined(__unix__) || defined(__APPLE__)
+arena= mmap(NULL,M,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANON,
+-1,0);
+if(arena==MAP_FAILED)
+arena= NULL;
+#endif
+/*:8*//*10:*/
+#line 368 "./weaver-memory-manager.tex"
+
+#if defined(_WIN32)
+{
+HANDLE handle;
+handle= CreateFileMappingA(INVALID_HANDLE_VALUE,NULL,
+PAGE_READWRITE,
+(DWORD)((DWORDLONG)M)/((DWORDLONG)4294967296),
+(DWORD)((DWORDLONG)M)%((DWORDLONG)4294967296),
+NULL);
+arena= MapViewOfFile(handle,FILE_MAP_READ|FILE_MAP_WRITE,0,0,0);
+CloseHandle(handle);
+}
+#endif
+/*:10*/
+#line 1516 "./weaver-memory-manager.tex"
+
+#endif
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+int mmap_flags= MAP_PRIVATE|MAP_ANON;
+#if defined(MAP_NORESERVE)
+mmap_flags|= MAP_NORESERVE;
+#endif
+arena= mmap(NULL,M,PROT_NONE,mmap_flags,-1,0);
+if(arena==MAP_FAILED)
+arena= NULL;
+else if(!commit_memory(arena,header_pages)||
+!commit_memory(((char*)arena)+M-p,p)){
+munmap(arena,M);
+arena= NULL;
+}
+#endif
+#if defined(_WIN32)
+arena= VirtualAlloc(NULL,M,MEM_RESERVE,PAGE_NOACCESS);
+if(arena!=NULL&&(!commit_memory(arena,header_pages)||
+!commit_memory(((char*)arena)+M-p,p))){
+VirtualFree(arena,0,MEM_RELEASE);
+arena= NULL;
+}
+#endif
+}
+/*:52*/
+#line 863 "./weaver-memory-manager.tex"
+
+}
+else if(flags&W_SNAPSHOT){
+/*187:*/
+#line 5125 "./weaver-memory-manager.tex"
+
+arena= NULL;
+#if defined(__linux__) && defined(SYS_memfd_create)
+fd= syscall(SYS_memfd_create,"weaver-snapshot",0);
+if(fd!=-1&&ftruncate(fd,M)==0){
+arena= MAP_FAILED;
+if(address!=NULL)
+arena= mmap(address,M,PROT_READ|PROT_WRITE,
+MAP_PRIVATE|W_MAP_FIXED_NOREPLACE,fd,0);
+if(arena==MAP_FAILED)
+arena= mmap(NULL,M,PROT_READ|PROT_WRITE,MAP_PRIVATE,fd,0);
+if(arena==MAP_FAILED)
+arena= NULL;
+}
+if(arena==NULL&&fd!=-1)
+close(fd);
+#endif
+/*:187*/
+#line 866 "./weaver-memory-manager.tex"
+
+}
+else if(flags&W_HUGE_PAGES){
+/*81:*/
+#line 2173 "./weaver-memory-manager.tex"
+
+#if defined(__EMSCRIPTEN__)
+/*8:*/
+#line 327 "./weaver-memory-manager.tex"
+
+#if defined(__EMSCRIPTEN__) || defined(__unix__) || defined(__APPLE__)
+arena= mmap(NULL,M,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANON,
+-1,0);
+if(arena==MAP_FAILED)
+arena= NULL;
+#endif
+/*:8*//*10:*/
+#line 368 "./weaver-memory-manager.tex"
+
+#if defined(_WIN32)
+{
+HANDLE handle;
+handle= CreateFileMappingA(INVALID_HANDLE_VALUE,NULL,
+PAGE_READWRITE,
+(DWORD)((DWORDLONG)M)/((DWORDLONG)4294967296),
+(DWORD)((DWORDLONG)M)%((DWORDLONG)4294967296),
+NULL);
+arena= MapViewOfFile(handle,FILE_MAP_READ|FILE_MAP_WRITE,0,0,0);
+CloseHandle(handle);
+}
+#endif
+/*:10*/
+#line 2175 "./weaver-memory-manager.tex"
+
+#endif
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+{
+char*region;
+size_t head;
+arena= MAP_FAILED;
+#if defined(MAP_HUGETLB)
+{
+int huge_flags= MAP_PRIVATE|MAP_ANON|MAP_HUGETLB;
+#if defined(MAP_HUGE_2MB)
+huge_flags|= MAP_HUGE_2MB;
+#endif
+arena= mmap(NULL,M,PROT_READ|PROT_WRITE,huge_flags,-1,0);
+}
+#endif
+if(arena==MAP_FAILED){
+region= mmap(NULL,M+p,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANON,
+-1,0);
+if(region==MAP_FAILED)
+arena= NULL;
+else{
+head= (p-((uintptr_t)region)%p)%p;
+if(head> 0)
+munmap(region,head);
+if(p-head> 0)
+munmap(region+head+M,p-head);
+arena= region+head;
+#if defined(MADV_HUGEPAGE)
+if(madvise(arena,M,MADV_HUGEPAGE)!=0)
+p= small_page;
+#else
+p= small_page;
+#endif
+}
+}
+}
+#endif
+#if defined(_WIN32)
+arena= VirtualAlloc(NULL,M,MEM_RESERVE|MEM_COMMIT|MEM_LARGE_PAGES,
+PAGE_READWRITE);
+if(arena==NULL){
+arena= VirtualAlloc(NULL,M,MEM_RESERVE|MEM_COMMIT,PAGE_READWRITE);
+p= small_page;
+}
+#endif
+/*:81*/
+#line 869 "./weaver-memory-manager.tex"
+
+}
+else if(address!=NULL){
+/*198:*/
+#line 5388 "./weaver-memory-manager.tex"
+
+#if defined(__EMSCRIPTEN__) || defined(__unix__) || defined(__APPLE__)
+arena= mmap(address,M,PROT_READ|PROT_WRITE,
+MAP_PRIVATE|MAP_ANON|W_MAP_FIXED_NOREPLACE,-1,0);
+if(arena==MAP_FAILED)
+arena= mmap(NULL,M,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANON,
+-1,0);
+if(arena==MAP_FAILED)
+arena= NULL;
+#endif
+#if defined(_WIN32)
+{
+HANDLE handle;
+handle= CreateFileMappingA(INVALID_HANDLE_VALUE,NULL,
+PAGE_READWRITE,
+(DWORD)((DWORDLONG)M)/((DWORDLONG)4294967296),
+(DWORD)((DWORDLONG)M)%((DWORDLONG)4294967296),
+NULL);
+arena= MapViewOfFileEx(handle,FILE_MAP_READ|FILE_MAP_WRITE,0,0,0,
+address);
+if(arena==NULL)
+arena= MapViewOfFile(handle,FILE_MAP_READ|FILE_MAP_WRITE,0,0,0);
+CloseHandle(handle);
+}
+#endif
+/*:198*/
+#line 872 "./weaver-memory-manager.tex"
+
+}
+else{
+/*8:*/
+#line 327 "./weaver-memory-manager.tex"
+
+#if defined(__EMSCRIPTEN__) || defined(__unix__) || defined(__APPLE__)
+arena= mmap(NULL,M,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANON,
+-1,0);
+if(arena==MAP_FAILED)
+arena= NULL;
+#endif
+/*:8*//*10:*/
+#line 368 "./weaver-memory-manager.tex"
+
+#if defined(_WIN32)
+{
+HANDLE handle;
+handle= CreateFileMappingA(INVALID_HANDLE_VALUE,NULL,
+PAGE_READWRITE,
+(DWORD)((DWORDLONG)M)/((DWORDLONG)4294967296),
+(DWORD)((DWORDLONG)M)%((DWORDLONG)4294967296),
+NULL);
+arena= MapViewOfFile(handle,FILE_MAP_READ|FILE_MAP_WRITE,0,0,0);
+CloseHandle(handle);
+}
+#endif
+/*:10*/
+#line 875 "./weaver-memory-manager.tex"
+
+}
+if(arena==NULL)return NULL;
+if(!(flags&W_GROWABLE)){
+/*85:*/
+#line 2284 "./weaver-memory-manager.tex"
+
+if(flags&W_PREFAULT)
+prefault((char*)arena,M,p);
+if(flags&W_LOCKED){
+bool locked;
+#if defined(__EMSCRIPTEN__)
+locked= true;
+#endif
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+locked= (mlock(arena,M)==0);
+#endif
+#if defined(_WIN32)
+locked= (VirtualLock(arena,M)!=0);
+#endif
+if(!locked){
+if(flags&W_HUGE_PAGES){
+/*54:*/
+#line 1574 "./weaver-memory-manager.tex"
+
+#if defined(__EMSCRIPTEN__) || defined(__unix__) || defined(__APPLE__)
+munmap(arena,M);
+#endif
+#if defined(_WIN32)
+VirtualFree(arena,0,MEM_RELEASE);
+#endif
+/*:54*/
+#line 2300 "./weaver-memory-manager.tex"
+
+}
+else{
+/*9:*/
+#line 349 "./weaver-memory-manager.tex"
+
+#if defined(__EMSCRIPTEN__) || defined(__unix__) || defined(__APPLE__)
+munmap(arena,M);
+#endif
+/*:9*//*11:*/
+#line 387 "./weaver-memory-manager.tex"
+
+#if defined(_WIN32)
+UnmapViewOfFile(arena);
+#endif
+/*:11*/
+#line 2303 "./weaver-memory-manager.tex"
+
+}
+return NULL;
+}
+}
+/*:85*/
+#line 879 "./weaver-memory-manager.tex"
+
+}
+
+/*30:*/
+#line 793 "./weaver-memory-manager.tex"
+
+{
+struct arena_header*header= (struct arena_header*)arena;
+header->right_free= ((char*)header)+M-1;
+header->left_free= ((char*)header)+sizeof(struct arena_header);
+header->remaining_space= M-sizeof(struct arena_header);
+header->total_size= M;
+header->left_point= NULL;
+header->right_point= NULL;
+/*46:*/
+#line 1369 "./weaver-memory-manager.tex"
+
+header->left_generation= 0;
+header->right_generation= 0;
+/*:46*//*57:*/
+#line 1607 "./weaver-memory-manager.tex"
+
+header->flags= flags;
+header->page_size= p;
+if(flags&W_GROWABLE){
+header->left_committed= ((char*)arena)+
+(((sizeof(struct arena_header)-1)/p)+1)*p;
+header->right_committed= ((char*)arena)+M-p;
+}
+else{
+header->left_committed= ((char*)arena)+M;
+header->right_committed= arena;
+}
+/*:57*//*62:*/
+#line 1741 "./weaver-memory-manager.tex"
+
+header->left_chunk= NULL;
+header->right_chunk= NULL;
+header->chunk_cache= NULL;
+header->cached_chunks= 0;
+/*:62*//*73:*/
+#line 2020 "./weaver-memory-manager.tex"
+
+header->trim_threshold= SIZE_MAX;
+/*:73*//*103:*/
+#line 2898 "./weaver-memory-manager.tex"
+
+header->left_destructors= NULL;
+header->right_destructors= NULL;
+/*:103*//*135:*/
+#line 3805 "./weaver-memory-manager.tex"
+
+header->allocations= 0;
+header->alignment_padding= 0;
+header->left_high_water= 0;
+header->right_high_water= 0;
+header->memory_points= 0;
+header->failed_allocations= 0;
+/*:135*//*141:*/
+#line 3947 "./weaver-memory-manager.tex"
+
+#if defined(W_LOCK_STATS)
+header->lock_acquisitions= 0;
+header->contended_acquisitions= 0;
+header->wait_time= 0;
+header->longest_wait= 0;
+header->longest_wait_operation= -1;
+header->longest_wait_side= -1;
+#endif
+/*:141*//*168:*/
+#line 4618 "./weaver-memory-manager.tex"
+
+header->base= arena;
+/*:168*//*177:*/
+#line 4855 "./weaver-memory-manager.tex"
+
+header->signature= W_SIGNATURE;
+/*:177*//*189:*/
+#line 5155 "./weaver-memory-manager.tex"
+
+header->snapshot_file= -1;
+/*:189*/
+#line 802 "./weaver-memory-manager.tex"
+
+{
+void*mutex= &(header->mutex);
+/*21:*/
+#line 560 "./weaver-memory-manager.tex"
+
+#if defined(__unix__) || defined(__APPLE__)
+if(flags&W_SHARED){
+/*170:*/
+#line 4694 "./weaver-memory-manager.tex"
+
+{
+pthread_mutexattr_t attributes;
+pthread_mutexattr_init(&attributes);
+pthread_mutexattr_setpshared(&attributes,PTHREAD_PROCESS_SHARED);
+#if defined(__linux__)
+pthread_mutexattr_setrobust(&attributes,PTHREAD_MUTEX_ROBUST);
+#endif
+error= pthread_mutex_init((pthread_mutex_t*)mutex,&attributes);
+pthread_mutexattr_destroy(&attributes);
+}
+/*:170*/
+#line 563 "./weaver-memory-manager.tex"
+
+}
+else
+error= pthread_mutex_init((pthread_mutex_t*)mutex,NULL);
+#endif
+#if defined(_WIN32)
+InitializeCriticalSection((CRITICAL_SECTION*)mutex);
+#endif
+/*:21*/
+#line 805 "./weaver-memory-manager.tex"
+
+}
+}
+/*:30*/
+#line 882 "./weaver-memory-manager.tex"
+
+
+if(error)return NULL;
+if(flags&W_SNAPSHOT){
+/*193:*/
+#line 5249 "./weaver-memory-manager.tex"
+
+#if defined(__linux__)
+((struct arena_header*)arena)->snapshot_file= fd;
+if(!discard_private_pages((struct arena_header*)arena,true)){
+munmap(arena,M);
+close(fd);
+return NULL;
+}
+#endif
+/*:193*/
+#line 886 "./weaver-memory-manager.tex"
+
+}
+/*154:*/
+#line 4451 "./weaver-memory-manager.tex"
+
+#if defined(W_TRACE)
+trace_event(W_TRACE_CREATE,arena,0,t,flags,arena);
+#endif
+/*:154*/
+#line 888 "./weaver-memory-manager.tex"
+
+return arena;
+}
+void*_Wcreate_arena_flags(size_t t,unsigned flags){
+return _Wcreate_arena_at(NULL,t,flags);
+}
+void*_Wcreate_arena(size_t t){
+return _Wcreate_arena_flags(t,0);
+}
+/*:31*/
+#line 5529 "./weaver-memory-manager.tex"
+
+/*32:*/
+#line 918 "./weaver-memory-manager.tex"
+
+bool _Wdestroy_arena(void*arena){
+struct arena_header*header= (struct arena_header*)arena;
+void*mutex= (void*)&(header->mutex);
+size_t M= header->total_size;
+bool ret= true;
+/*107:*/
+#line 2997 "./weaver-memory-manager.tex"
+
+{
+struct destructor*d;
+for(d= header->right_destructors;d!=NULL;d= d->previous)
+d->function(d->object);
+for(d= header->left_destructors;d!=NULL;d= d->previous)
+d->function(d->object);
+}
+/*:107*/
+#line 924 "./weaver-memory-manager.tex"
+
+#if defined(W_DEBUG_MEMORY)
+{
+struct _Wstats stats;
+_Wget_stats(arena,&stats);
+printf("High water: %zu (left) + %zu (right) of %zu bytes\n",
+stats.left_high_water,stats.right_high_water,stats.total_size);
+}
+#endif
+/*22:*/
+#line 578 "./weaver-memory-manager.tex"
+
+#if defined(__unix__) || defined(__APPLE__)
+pthread_mutex_destroy((pthread_mutex_t*)mutex);
+#endif
+#if defined(_WIN32)
+DeleteCriticalSection((CRITICAL_SECTION*)mutex);
+#endif
+/*:22*/
+#line 933 "./weaver-memory-manager.tex"
+
+if(header->total_size!=header->remaining_space+
+sizeof(struct arena_header))
+ret= false;
+/*70:*/
+#line 1930 "./weaver-memory-manager.tex"
+
+if(header->flags&W_CHAINED){
+struct chunk_header*chunk;
+void*lists[3];
+int i;
+lists[0]= header->left_chunk;
+lists[1]= header->right_chunk;
+lists[2]= header->chunk_cache;
+if(lists[0]!=NULL||lists[1]!=NULL)
+ret= false;
+for(i= 0;i<3;i++)
+while(lists[i]!=NULL){
+chunk= (struct chunk_header*)lists[i];
+lists[i]= chunk->previous;
+unmap_chunk(chunk);
+}
+}
+/*:70*/
+#line 937 "./weaver-memory-manager.tex"
+
+/*190:*/
+#line 5161 "./weaver-memory-manager.tex"
+
+#if defined(__linux__)
+if(header->flags&W_SNAPSHOT)
+close(header->snapshot_file);
+#endif
+/*:190*/
+#line 938 "./weaver-memory-manager.tex"
+
+if(header->flags&(W_GROWABLE|W_HUGE_PAGES)){
+/*54:*/
+#line 1574 "./weaver-memory-manager.tex"
+
+#if defined(__EMSCRIPTEN__) || defined(__unix__) || defined(__APPLE__)
+munmap(arena,M);
+#endif
+#if defined(_WIN32)
+VirtualFree(arena,0,MEM_RELEASE);
+#endif
+/*:54*/
+#line 940 "./weaver-memory-manager.tex"
+
+}
+else{
+/*9:*/
+#line 349 "./weaver-memory-manager.tex"
+
+#if defined(__EMSCRIPTEN__) || defined(__unix__) || defined(__APPLE__)
+munmap(arena,M);
+#endif
+/*:9*//*11:*/
+#line 387 "./weaver-memory-manager.tex"
+
+#if defined(_WIN32)
+UnmapViewOfFile(arena);
+#endif
+/*:11*/
+#line 943 "./weaver-memory-manager.tex"
+
+}
+/*158:*/
+#line 4483 "./weaver-memory-manager.tex"
+
+#if defined(W_TRACE)
+trace_event(W_TRACE_DESTROY,arena,0,M,0,(ret)?(arena):(NULL));
+#endif
+/*:158*/
+#line 945 "./weaver-memory-manager.tex"
+
+return ret;
+}
+/*:32*/
+#line 5530 "./weaver-memory-manager.tex"
+
+/*38:*/
+#line 1128 "./weaver-memory-manager.tex"
+
+void*_Walloc(void*arena,unsigned a,int right,size_t t){
+void*p= NULL,*old_free;
+struct arena_header*header= (struct arena_header*)arena;
+if(/*63:*/
+#line 1755 "./weaver-memory-manager.tex"
+
+(!(header->flags&W_CHAINED)||
+load_pointer((right)?(&(header->right_chunk)):
+(&(header->left_chunk)))==NULL)
+/*:63*/
+#line 1132 "./weaver-memory-manager.tex"
+){
+/*37:*/
+#line 1062 "./weaver-memory-manager.tex"
+
+{
+int offset;
+size_t r;
+void*new_free;
+struct arena_header*head= (struct arena_header*)arena;
+for(;;){
+r= load_size(&(head->remaining_space));
+if(r<t){
+p= NULL;
+break;
+}
+if(right){
+old_free= load_pointer(&(head->right_free));
+p= ((char*)old_free)-t+1;
+/*36:*/
+#line 1010 "./weaver-memory-manager.tex"
+
+offset= 0;
+if(a> 1){
+void*new_p= (void*)(((uintptr_t)p)&(~((uintptr_t)a-1)));
+offset= ((char*)p)-((char*)new_p);
+p= new_p;
+}
+/*:36*/
+#line 1077 "./weaver-memory-manager.tex"
+
+new_free= (char*)p-1;
+}
+else{
+old_free= load_pointer(&(head->left_free));
+p= old_free;
+/*34:*/
+#line 981 "./weaver-memory-manager.tex"
+
+offset= 0;
+if(a> 1){
+void*new_p= ((char*)p)+(a-1);
+new_p= (void*)(((uintptr_t)new_p)&(~((uintptr_t)a-1)));
+offset= ((char*)new_p)-((char*)p);
+p= new_p;
+}
+/*:34*/
+#line 1083 "./weaver-memory-manager.tex"
+
+new_free= (char*)p+t;
+}
+if(r<t+offset){
+p= NULL;
+break;
+}
+if(!cas_size(&(head->remaining_space),r,r-t-offset))
+continue;
+if((head->flags&W_GROWABLE)&&
+!grow_stack(head,right,(right)?((char*)p):((char*)new_free))){
+add_size(&(head->remaining_space),t+offset);
+p= NULL;
+break;
+}
+if(cas_pointer((right)?(&(head->right_free)):(&(head->left_free)),
+old_free,new_free))
+break;
+add_size(&(head->remaining_space),t+offset);
+}
+if(p!=NULL&&offset!=0)
+add_size(&(head->alignment_padding),offset);
+}
+/*:37*/
+#line 1133 "./weaver-memory-manager.tex"
+
+}
+/*64:*/
+#line 1768 "./weaver-memory-manager.tex"
+
+if(p==NULL&&(header->flags&W_CHAINED)){
+void*mutex= (void*)&(header->mutex);
+/*23:*/
+#line 591 "./weaver-memory-manager.tex"
+
+#if defined(W_LOCK_STATS)
+lock_mutex(mutex,__func__,right);
+#else
+#if defined(__unix__) || defined(__APPLE__)
+if(pthread_mutex_lock((pthread_mutex_t*)mutex)==EOWNERDEAD){
+/*171:*/
+#line 4716 "./weaver-memory-manager.tex"
+
+#if defined(__linux__)
+pthread_mutex_consistent((pthread_mutex_t*)mutex);
+#endif
+/*:171*/
+#line 597 "./weaver-memory-manager.tex"
+
+}
+#endif
+#if defined(_WIN32)
+EnterCriticalSection((CRITICAL_SECTION*)mutex);
+#endif
+#endif
+/*:23*/
+#line 1771 "./weaver-memory-manager.tex"
+
+p= chunk_alloc(header,a,right,t,&old_free);
+/*24:*/
+#line 611 "./weaver-memory-manager.tex"
+
+#if defined(__unix__) || defined(__APPLE__)
+pthread_mutex_unlock((pthread_mutex_t*)mutex);
+#endif
+#if defined(_WIN32)
+LeaveCriticalSection((CRITICAL_SECTION*)mutex);
+#endif
+/*:24*/
+#line 1773 "./weaver-memory-manager.tex"
+
+}
+/*:64*/
+#line 1135 "./weaver-memory-manager.tex"
+
+/*136:*/
+#line 3819 "./weaver-memory-manager.tex"
+
+if(p==NULL)
+add_size(&(header->failed_allocations),1);
+else
+add_size(&(header->allocations),1);
+/*:136*/
+#line 1136 "./weaver-memory-manager.tex"
+
+/*155:*/
+#line 4459 "./weaver-memory-manager.tex"
+
+#if defined(W_TRACE)
+trace_event(W_TRACE_ALLOC,arena,right,t,a,p);
+#endif
+/*:155*/
+#line 1137 "./weaver-memory-manager.tex"
+
+return p;
+}
+/*:38*/
+#line 5531 "./weaver-memory-manager.tex"
+
+/*42:*/
+#line 1231 "./weaver-memory-manager.tex"
+
+bool _Wmempoint(void*arena,unsigned a,int right){
+struct arena_header*header= (struct arena_header*)arena;
+void*mutex= (void*)&(header->mutex);
+char*p= NULL;
+void*old_free;
+struct memory_point*point;
+size_t t= sizeof(struct memory_point);
+/*23:*/
+#line 591 "./weaver-memory-manager.tex"
+
+#if defined(W_LOCK_STATS)
+lock_mutex(mutex,__func__,right);
+#else
+#if defined(__unix__) || defined(__APPLE__)
+if(pthread_mutex_lock((pthread_mutex_t*)mutex)==EOWNERDEAD){
+/*171:*/
+#line 4716 "./weaver-memory-manager.tex"
+
+#if defined(__linux__)
+pthread_mutex_consistent((pthread_mutex_t*)mutex);
+#endif
+/*:171*/
+#line 597 "./weaver-memory-manager.tex"
+
+}
+#endif
+#if defined(_WIN32)
+EnterCriticalSection((CRITICAL_SECTION*)mutex);
+#endif
+#endif
+/*:23*/
+#line 1239 "./weaver-memory-manager.tex"
+
+if(/*63:*/
+#line 1755 "./weaver-memory-manager.tex"
+
+(!(header->flags&W_CHAINED)||
+load_pointer((right)?(&(header->right_chunk)):
+(&(header->left_chunk)))==NULL)
+/*:63*/
+#line 1240 "./weaver-memory-manager.tex"
+){
+/*37:*/
+#line 1062 "./weaver-memory-manager.tex"
+
+{
+int offset;
+size_t r;
+void*new_free;
+struct arena_header*head= (struct arena_header*)arena;
+for(;;){
+r= load_size(&(head->remaining_space));
+if(r<t){
+p= NULL;
+break;
+}
+if(right){
+old_free= load_pointer(&(head->right_free));
+p= ((char*)old_free)-t+1;
+/*36:*/
+#line 1010 "./weaver-memory-manager.tex"
+
+offset= 0;
+if(a> 1){
+void*new_p= (void*)(((uintptr_t)p)&(~((uintptr_t)a-1)));
+offset= ((char*)p)-((char*)new_p);
+p= new_p;
+}
+/*:36*/
+#line 1077 "./weaver-memory-manager.tex"
+
+new_free= (char*)p-1;
+}
+else{
+old_free= load_pointer(&(head->left_free));
+p= old_free;
+/*34:*/
+#line 981 "./weaver-memory-manager.tex"
+
+offset= 0;
+if(a> 1){
+void*new_p= ((char*)p)+(a-1);
+new_p= (void*)(((uintptr_t)new_p)&(~((uintptr_t)a-1)));
+offset= ((char*)new_p)-((char*)p);
+p= new_p;
+}
+/*:34*/
+#line 1083 "./weaver-memory-manager.tex"
+
+new_free= (char*)p+t;
+}
+if(r<t+offset){
+p= NULL;
+break;
+}
+if(!cas_size(&(head->remaining_space),r,r-t-offset))
+continue;
+if((head->flags&W_GROWABLE)&&
+!grow_stack(head,right,(right)?((char*)p):((char*)new_free))){
+add_size(&(head->remaining_space),t+offset);
+p= NULL;
+break;
+}
+if(cas_pointer((right)?(&(head->right_free)):(&(head->left_free)),
+old_free,new_free))
+break;
+add_size(&(head->remaining_space),t+offset);
+}
+if(p!=NULL&&offset!=0)
+add_size(&(head->alignment_padding),offset);
+}
+/*:37*/
+#line 1241 "./weaver-memory-manager.tex"
+
+}
+/*65:*/
+#line 1781 "./weaver-memory-manager.tex"
+
+if(p==NULL&&(header->flags&W_CHAINED))
+p= chunk_alloc(header,a,right,t,&old_free);
+/*:65*/
+#line 1243 "./weaver-memory-manager.tex"
+
+point= (struct memory_point*)p;
+if(point!=NULL){
+point->free= old_free;
+/*104:*/
+#line 2905 "./weaver-memory-manager.tex"
+
+point->destructors= (right)?(header->right_destructors):
+(header->left_destructors);
+/*:104*/
+#line 1247 "./weaver-memory-manager.tex"
+
+if(right){
+point->last_memory_point= header->right_point;
+header->right_point= point;
+}
+else{
+point->last_memory_point= header->left_point;
+header->left_point= point;
+}
+}
+/*24:*/
+#line 611 "./weaver-memory-manager.tex"
+
+#if defined(__unix__) || defined(__APPLE__)
+pthread_mutex_unlock((pthread_mutex_t*)mutex);
+#endif
+#if defined(_WIN32)
+LeaveCriticalSection((CRITICAL_SECTION*)mutex);
+#endif
+/*:24*/
+#line 1257 "./weaver-memory-manager.tex"
+
+/*156:*/
+#line 4467 "./weaver-memory-manager.tex"
+
+#if defined(W_TRACE)
+trace_event(W_TRACE_MEMPOINT,arena,right,t,a,point);
+#endif
+/*:156*/
+#line 1258 "./weaver-memory-manager.tex"
+
+if(point==NULL)
+return false;
+add_size(&(header->memory_points),1);
+return true;
+}
+/*:42*/
+#line 5532 "./weaver-memory-manager.tex"
+
+/*43:*/
+#line 1276 "./weaver-memory-manager.tex"
+
+void _Wtrash(void*arena,int right){
+struct arena_header*head= (struct arena_header*)arena;
+void*mutex= (void*)&(head->mutex);
+struct memory_point*point;
+void*old_free,*new_free;
+/*23:*/
+#line 591 "./weaver-memory-manager.tex"
+
+#if defined(W_LOCK_STATS)
+lock_mutex(mutex,__func__,right);
+#else
+#if defined(__unix__) || defined(__APPLE__)
+if(pthread_mutex_lock((pthread_mutex_t*)mutex)==EOWNERDEAD){
+/*171:*/
+#line 4716 "./weaver-memory-manager.tex"
+
+#if defined(__linux__)
+pthread_mutex_consistent((pthread_mutex_t*)mutex);
+#endif
+/*:171*/
+#line 597 "./weaver-memory-manager.tex"
+
+}
+#endif
+#if defined(_WIN32)
+EnterCriticalSection((CRITICAL_SECTION*)mutex);
+#endif
+#endif
+/*:23*/
+#line 1282 "./weaver-memory-manager.tex"
+
+if(right){
+point= head->right_point;
+}
+else{
+point= head->left_point;
+}
+if(point==NULL){
+/*39:*/
+#line 1157 "./weaver-memory-manager.tex"
+
+{
+struct arena_header*header= arena;
+if(right)
+new_free= ((char*)arena)+header->total_size-1;
+else
+new_free= ((char*)arena)+sizeof(struct arena_header);
+}
+/*:39*/
+#line 1290 "./weaver-memory-manager.tex"
+
+}
+else
+new_free= point->free;
+/*128:*/
+#line 3626 "./weaver-memory-manager.tex"
+
+record_high_water(head,right);
+/*106:*/
+#line 2971 "./weaver-memory-manager.tex"
+
+{
+struct destructor*d,*last;
+last= (point==NULL)?(NULL):(point->destructors);
+d= (right)?(head->right_destructors):(head->left_destructors);
+while(d!=last){
+if(right)
+head->right_destructors= last;
+else
+head->left_destructors= last;
+/*24:*/
+#line 611 "./weaver-memory-manager.tex"
+
+#if defined(__unix__) || defined(__APPLE__)
+pthread_mutex_unlock((pthread_mutex_t*)mutex);
+#endif
+#if defined(_WIN32)
+LeaveCriticalSection((CRITICAL_SECTION*)mutex);
+#endif
+/*:24*/
+#line 2981 "./weaver-memory-manager.tex"
+
+while(d!=last){
+d->function(d->object);
+d= d->previous;
+}
+/*23:*/
+#line 591 "./weaver-memory-manager.tex"
+
+#if defined(W_LOCK_STATS)
+lock_mutex(mutex,__func__,right);
+#else
+#if defined(__unix__) || defined(__APPLE__)
+if(pthread_mutex_lock((pthread_mutex_t*)mutex)==EOWNERDEAD){
+/*171:*/
+#line 4716 "./weaver-memory-manager.tex"
+
+#if defined(__linux__)
+pthread_mutex_consistent((pthread_mutex_t*)mutex);
+#endif
+/*:171*/
+#line 597 "./weaver-memory-manager.tex"
+
+}
+#endif
+#if defined(_WIN32)
+EnterCriticalSection((CRITICAL_SECTION*)mutex);
+#endif
+#endif
+/*:23*/
+#line 2986 "./weaver-memory-manager.tex"
+
+d= (right)?(head->right_destructors):(head->left_destructors);
+}
+}
+/*:106*/
+#line 3628 "./weaver-memory-manager.tex"
+
+if(right)
+head->right_point= (point==NULL)?(NULL):(point->last_memory_point);
+else
+head->left_point= (point==NULL)?(NULL):(point->last_memory_point);
+/*47:*/
+#line 1380 "./weaver-memory-manager.tex"
+
+if(right)
+add_size(&(head->right_generation),1);
+else
+add_size(&(head->left_generation),1);
+/*:47*/
+#line 3633 "./weaver-memory-manager.tex"
+
+/*69:*/
+#line 1906 "./weaver-memory-manager.tex"
+
+if(head->flags&W_CHAINED){
+void**current= (right)?(&(head->right_chunk)):(&(head->left_chunk));
+struct chunk_header*chunk;
+while(*current!=NULL){
+chunk= (struct chunk_header*)*current;
+if((char*)new_free>=((char*)chunk)+sizeof(struct chunk_header)&&
+(char*)new_free<=((char*)chunk)+chunk->size){
+chunk->free= (char*)new_free;
+new_free= NULL;
+break;
+}
+exchange_pointer(current,chunk->previous);
+release_chunk(head,chunk);
+}
+}
+/*:69*/
+#line 3634 "./weaver-memory-manager.tex"
+
+if(new_free!=NULL){
+/*76:*/
+#line 2058 "./weaver-memory-manager.tex"
+
+{
+char*top;
+if(right){
+top= ((char*)load_pointer(&(head->right_free)))+1;
+if((size_t)(((char*)new_free)+1-top)> head->trim_threshold)
+release_pages(head,top,
+((char*)new_free)+1-head->trim_threshold);
+}
+else{
+top= (char*)load_pointer(&(head->left_free));
+if((size_t)(top-((char*)new_free))> head->trim_threshold)
+release_pages(head,((char*)new_free)+head->trim_threshold,
+top);
+}
+}
+/*:76*/
+#line 3636 "./weaver-memory-manager.tex"
+
+/*40:*/
+#line 1175 "./weaver-memory-manager.tex"
+
+{
+struct arena_header*header= arena;
+if(right){
+old_free= exchange_pointer(&(header->right_free),new_free);
+add_size(&(header->remaining_space),
+((char*)new_free)-((char*)old_free));
+}
+else{
+old_free= exchange_pointer(&(header->left_free),new_free);
+add_size(&(header->remaining_space),
+((char*)old_free)-((char*)new_free));
+}
+}
+/*:40*/
+#line 3637 "./weaver-memory-manager.tex"
+
+}
+/*:128*/
+#line 1294 "./weaver-memory-manager.tex"
+
+/*24:*/
+#line 611 "./weaver-memory-manager.tex"
+
+#if defined(__unix__) || defined(__APPLE__)
+pthread_mutex_unlock((pthread_mutex_t*)mutex);
+#endif
+#if defined(_WIN32)
+LeaveCriticalSection((CRITICAL_SECTION*)mutex);
+#endif
+/*:24*/
+#line 1295 "./weaver-memory-manager.tex"
+
+/*157:*/
+#line 4475 "./weaver-memory-manager.tex"
+
+#if defined(W_TRACE)
+trace_event(W_TRACE_TRASH,arena,right,0,0,new_free);
+#endif
+/*:157*/
+#line 1296 "./weaver-memory-manager.tex"
+
+}
+/*:43*/
+#line 5533 "./weaver-memory-manager.tex"
+
+/*48:*/
+#line 1392 "./weaver-memory-manager.tex"
+
+void _Winit_buffer(struct _Wbuffer*buffer,void*arena,int right,
+size_t t){
+buffer->arena= arena;
+buffer->right= right;
+buffer->size= t;
+buffer->free= NULL;
+buffer->end= NULL;
+buffer->generation= 0;
+}
+/*:48*/
+#line 5534 "./weaver-memory-manager.tex"
+
+/*49:*/
+#line 1418 "./weaver-memory-manager.tex"
+
+void*_Walloc_buffer(struct _Wbuffer*buffer,unsigned a,size_t t){
+struct arena_header*header= (struct arena_header*)buffer->arena;
+size_t generation;
+char*p;
+int offset;
+if(buffer->right)
+generation= load_size(&(header->right_generation));
+else
+generation= load_size(&(header->left_generation));
+if(buffer->free!=NULL&&generation==buffer->generation){
+p= buffer->free;
+/*34:*/
+#line 981 "./weaver-memory-manager.tex"
+
+offset= 0;
+if(a> 1){
+void*new_p= ((char*)p)+(a-1);
+new_p= (void*)(((uintptr_t)new_p)&(~((uintptr_t)a-1)));
+offset= ((char*)new_p)-((char*)p);
+p= new_p;
+}
+/*:34*/
+#line 1430 "./weaver-memory-manager.tex"
+
+if(t+offset<=(size_t)(buffer->end-buffer->free)){
+buffer->free= p+t;
+return p;
+}
+}
+if(t+((a==0)?(0):(a-1))> buffer->size/2)
+return _Walloc(buffer->arena,a,buffer->right,t);
+/*50:*/
+#line 1455 "./weaver-memory-manager.tex"
+
+p= (char*)_Walloc(buffer->arena,0,buffer->right,buffer->size);
+if(p==NULL)
+return _Walloc(buffer->arena,a,buffer->right,t);
+buffer->generation= generation;
+buffer->end= p+buffer->size;
+/*34:*/
+#line 981 "./weaver-memory-manager.tex"
+
+offset= 0;
+if(a> 1){
+void*new_p= ((char*)p)+(a-1);
+new_p= (void*)(((uintptr_t)new_p)&(~((uintptr_t)a-1)));
+offset= ((char*)new_p)-((char*)p);
+p= new_p;
+}
+/*:34*/
+#line 1461 "./weaver-memory-manager.tex"
+
+buffer->free= p+t;
+/*:50*/
+#line 1438 "./weaver-memory-manager.tex"
+
+return p;
+}
+/*:49*/
+#line 5535 "./weaver-memory-manager.tex"
+
+/*75:*/
+#line 2036 "./weaver-memory-manager.tex"
+
+void _Wset_trim_threshold(void*arena,size_t threshold){
+struct arena_header*header= (struct arena_header*)arena;
+void*mutex= (void*)&(header->mutex);
+/*142:*/
+#line 3966 "./weaver-memory-manager.tex"
+
+#if defined(W_LOCK_STATS)
+lock_mutex(mutex,__func__,-1);
+#else
+/*23:*/
+#line 591 "./weaver-memory-manager.tex"
+
+#if defined(W_LOCK_STATS)
+lock_mutex(mutex,__func__,right);
+#else
+#if defined(__unix__) || defined(__APPLE__)
+if(pthread_mutex_lock((pthread_mutex_t*)mutex)==EOWNERDEAD){
+/*171:*/
+#line 4716 "./weaver-memory-manager.tex"
+
+#if defined(__linux__)
+pthread_mutex_consistent((pthread_mutex_t*)mutex);
+#endif
+/*:171*/
+#line 597 "./weaver-memory-manager.tex"
+
+}
+#endif
+#if defined(_WIN32)
+EnterCriticalSection((CRITICAL_SECTION*)mutex);
+#endif
+#endif
+/*:23*/
+#line 3970 "./weaver-memory-manager.tex"
+
+#endif
+/*:142*/
+#line 2040 "./weaver-memory-manager.tex"
+
+header->trim_threshold= threshold;
+/*24:*/
+#line 611 "./weaver-memory-manager.tex"
+
+#if defined(__unix__) || defined(__APPLE__)
+pthread_mutex_unlock((pthread_mutex_t*)mutex);
+#endif
+#if defined(_WIN32)
+LeaveCriticalSection((CRITICAL_SECTION*)mutex);
+#endif
+/*:24*/
+#line 2042 "./weaver-memory-manager.tex"
+
+}
+/*:75*/
+#line 5536 "./weaver-memory-manager.tex"
+
+/*78:*/
+#line 2093 "./weaver-memory-manager.tex"
+
+void _Wtrim(void*arena){
+struct arena_header*header= (struct arena_header*)arena;
+void*mutex= (void*)&(header->mutex);
+struct chunk_header*chunk;
+/*142:*/
+#line 3966 "./weaver-memory-manager.tex"
+
+#if defined(W_LOCK_STATS)
+lock_mutex(mutex,__func__,-1);
+#else
+/*23:*/
+#line 591 "./weaver-memory-manager.tex"
+
+#if defined(W_LOCK_STATS)
+lock_mutex(mutex,__func__,right);
+#else
+#if defined(__unix__) || defined(__APPLE__)
+if(pthread_mutex_lock((pthread_mutex_t*)mutex)==EOWNERDEAD){
+/*171:*/
+#line 4716 "./weaver-memory-manager.tex"
+
+#if defined(__linux__)
+pthread_mutex_consistent((pthread_mutex_t*)mutex);
+#endif
+/*:171*/
+#line 597 "./weaver-memory-manager.tex"
+
+}
+#endif
+#if defined(_WIN32)
+EnterCriticalSection((CRITICAL_SECTION*)mutex);
+#endif
+#endif
+/*:23*/
+#line 3970 "./weaver-memory-manager.tex"
+
+#endif
+/*:142*/
+#line 2098 "./weaver-memory-manager.tex"
+
+release_pages(header,(char*)load_pointer(&(header->left_free)),
+((char*)load_pointer(&(header->right_free)))+1);
+while(header->chunk_cache!=NULL){
+chunk= (struct chunk_header*)header->chunk_cache;
+header->chunk_cache= chunk->previous;
+unmap_chunk(chunk);
+}
+header->cached_chunks= 0;
+/*24:*/
+#line 611 "./weaver-memory-manager.tex"
+
+#if defined(__unix__) || defined(__APPLE__)
+pthread_mutex_unlock((pthread_mutex_t*)mutex);
+#endif
+#if defined(_WIN32)
+LeaveCriticalSection((CRITICAL_SECTION*)mutex);
+#endif
+/*:24*/
+#line 2107 "./weaver-memory-manager.tex"
+
+}
+/*:78*/
+#line 5537 "./weaver-memory-manager.tex"
+
+/*83:*/
+#line 2238 "./weaver-memory-manager.tex"
+
+size_t _Wpage_size(void*arena){
+return((struct arena_header*)arena)->page_size;
+}
+/*:83*/
+#line 5538 "./weaver-memory-manager.tex"
+
+/*91:*/
+#line 2480 "./weaver-memory-manager.tex"
+
+bool _Walloc_batch(void*arena,int right,size_t count,
+const size_t*sizes,const unsigned*alignments,
+void**out){
+struct arena_header*header= (struct arena_header*)arena;
+void*old_free,*new_free;
+char*p;
+size_t i,r,total,padding;
+if(/*63:*/
+#line 1755 "./weaver-memory-manager.tex"
+
+(!(header->flags&W_CHAINED)||
+load_pointer((right)?(&(header->right_chunk)):
+(&(header->left_chunk)))==NULL)
+/*:63*/
+#line 2488 "./weaver-memory-manager.tex"
+){
+for(;;){
+r= load_size(&(header->remaining_space));
+if(right)
+old_free= load_pointer(&(header->right_free));
+else
+old_free= load_pointer(&(header->left_free));
+/*92:*/
+#line 2535 "./weaver-memory-manager.tex"
+
+p= (char*)old_free;
+total= 0;
+padding= 0;
+for(i= 0;i<count;i++){
+unsigned a= alignments[i];
+size_t t= sizes[i];
+int offset;
+if(right){
+p= p-t+1;
+/*36:*/
+#line 1010 "./weaver-memory-manager.tex"
+
+offset= 0;
+if(a> 1){
+void*new_p= (void*)(((uintptr_t)p)&(~((uintptr_t)a-1)));
+offset= ((char*)p)-((char*)new_p);
+p= new_p;
+}
+/*:36*/
+#line 2545 "./weaver-memory-manager.tex"
+
+out[i]= p;
+p= p-1;
+}
+else{
+/*34:*/
+#line 981 "./weaver-memory-manager.tex"
+
+offset= 0;
+if(a> 1){
+void*new_p= ((char*)p)+(a-1);
+new_p= (void*)(((uintptr_t)new_p)&(~((uintptr_t)a-1)));
+offset= ((char*)new_p)-((char*)p);
+p= new_p;
+}
+/*:34*/
+#line 2550 "./weaver-memory-manager.tex"
+
+out[i]= p;
+p= p+t;
+}
+total+= t+offset;
+padding+= offset;
+}
+new_free= p;
+/*:92*/
+#line 2495 "./weaver-memory-manager.tex"
+
+if(r<total)
+break;
+if(!cas_size(&(header->remaining_space),r,r-total))
+continue;
+if((header->flags&W_GROWABLE)&&
+!grow_stack(header,right,(right)?(((char*)new_free)+1):
+((char*)new_free))){
+add_size(&(header->remaining_space),total);
+break;
+}
+if(cas_pointer((right)?(&(header->right_free)):
+(&(header->left_free)),old_free,new_free)){
+add_size(&(header->allocations),count);
+add_size(&(header->alignment_padding),padding);
+/*165:*/
+#line 4568 "./weaver-memory-manager.tex"
+
+#if defined(W_TRACE)
+trace_batch(arena,right,count,sizes,alignments,out);
+#endif
+/*:165*/
+#line 2510 "./weaver-memory-manager.tex"
+
+return true;
+}
+add_size(&(header->remaining_space),total);
+}
+}
+if(header->flags&W_CHAINED){
+/*93:*/
+#line 2569 "./weaver-memory-manager.tex"
+
+void*mutex= (void*)&(header->mutex);
+int stack= right;
+total= 0;
+for(i= 0;i<count;i++)
+total+= sizes[i]+((alignments[i]==0)?(0):(alignments[i]-1));
+/*23:*/
+#line 591 "./weaver-memory-manager.tex"
+
+#if defined(W_LOCK_STATS)
+lock_mutex(mutex,__func__,right);
+#else
+#if defined(__unix__) || defined(__APPLE__)
+if(pthread_mutex_lock((pthread_mutex_t*)mutex)==EOWNERDEAD){
+/*171:*/
+#line 4716 "./weaver-memory-manager.tex"
+
+#if defined(__linux__)
+pthread_mutex_consistent((pthread_mutex_t*)mutex);
+#endif
+/*:171*/
+#line 597 "./weaver-memory-manager.tex"
+
+}
+#endif
+#if defined(_WIN32)
+EnterCriticalSection((CRITICAL_SECTION*)mutex);
+#endif
+#endif
+/*:23*/
+#line 2575 "./weaver-memory-manager.tex"
+
+p= (char*)chunk_alloc(header,0,right,total,&old_free);
+/*24:*/
+#line 611 "./weaver-memory-manager.tex"
+
+#if defined(__unix__) || defined(__APPLE__)
+pthread_mutex_unlock((pthread_mutex_t*)mutex);
+#endif
+#if defined(_WIN32)
+LeaveCriticalSection((CRITICAL_SECTION*)mutex);
+#endif
+/*:24*/
+#line 2577 "./weaver-memory-manager.tex"
+
+if(p!=NULL){
+old_free= p;
+right= 0;
+/*92:*/
+#line 2535 "./weaver-memory-manager.tex"
+
+p= (char*)old_free;
+total= 0;
+padding= 0;
+for(i= 0;i<count;i++){
+unsigned a= alignments[i];
+size_t t= sizes[i];
+int offset;
+if(right){
+p= p-t+1;
+/*36:*/
+#line 1010 "./weaver-memory-manager.tex"
+
+offset= 0;
+if(a> 1){
+void*new_p= (void*)(((uintptr_t)p)&(~((uintptr_t)a-1)));
+offset= ((char*)p)-((char*)new_p);
+p= new_p;
+}
+/*:36*/
+#line 2545 "./weaver-memory-manager.tex"
+
+out[i]= p;
+p= p-1;
+}
+else{
+/*34:*/
+#line 981 "./weaver-memory-manager.tex"
+
+offset= 0;
+if(a> 1){
+void*new_p= ((char*)p)+(a-1);
+new_p= (void*)(((uintptr_t)new_p)&(~((uintptr_t)a-1)));
+offset= ((char*)new_p)-((char*)p);
+p= new_p;
+}
+/*:34*/
+#line 2550 "./weaver-memory-manager.tex"
+
+out[i]= p;
+p= p+t;
+}
+total+= t+offset;
+padding+= offset;
+}
+new_free= p;
+/*:92*/
+#line 2581 "./weaver-memory-manager.tex"
+
+right= stack;
+add_size(&(header->allocations),count);
+add_size(&(header->alignment_padding),padding);
+/*165:*/
+#line 4568 "./weaver-memory-manager.tex"
+
+#if defined(W_TRACE)
+trace_batch(arena,right,count,sizes,alignments,out);
+#endif
+/*:165*/
+#line 2585 "./weaver-memory-manager.tex"
+
+return true;
+}
+/*:93*/
+#line 2517 "./weaver-memory-manager.tex"
+
+}
+for(i= 0;i<count;i++)
+out[i]= NULL;
+add_size(&(header->failed_allocations),count);
+/*165:*/
+#line 4568 "./weaver-memory-manager.tex"
+
+#if defined(W_TRACE)
+trace_batch(arena,right,count,sizes,alignments,out);
+#endif
+/*:165*/
+#line 2522 "./weaver-memory-manager.tex"
+
+return false;
+}
+/*:91*/
+#line 5539 "./weaver-memory-manager.tex"
+
+/*105:*/
+#line 2918 "./weaver-memory-manager.tex"
+
+bool _Wregister_destructor(void*arena,int right,
+void(*destructor)(void*),void*object){
+struct arena_header*header= (struct arena_header*)arena;
+void*mutex= (void*)&(header->mutex);
+char*p= NULL;
+void*old_free;
+struct destructor*d;
+unsigned a= sizeof(void*);
+size_t t= sizeof(struct destructor);
+if(header->flags&(W_FILE|W_SHARED))
+return false;
+/*23:*/
+#line 591 "./weaver-memory-manager.tex"
+
+#if defined(W_LOCK_STATS)
+lock_mutex(mutex,__func__,right);
+#else
+#if defined(__unix__) || defined(__APPLE__)
+if(pthread_mutex_lock((pthread_mutex_t*)mutex)==EOWNERDEAD){
+/*171:*/
+#line 4716 "./weaver-memory-manager.tex"
+
+#if defined(__linux__)
+pthread_mutex_consistent((pthread_mutex_t*)mutex);
+#endif
+/*:171*/
+#line 597 "./weaver-memory-manager.tex"
+
+}
+#endif
+#if defined(_WIN32)
+EnterCriticalSection((CRITICAL_SECTION*)mutex);
+#endif
+#endif
+/*:23*/
+#line 2930 "./weaver-memory-manager.tex"
+
+if(/*63:*/
+#line 1755 "./weaver-memory-manager.tex"
+
+(!(header->flags&W_CHAINED)||
+load_pointer((right)?(&(header->right_chunk)):
+(&(header->left_chunk)))==NULL)
+/*:63*/
+#line 2931 "./weaver-memory-manager.tex"
+){
+/*37:*/
+#line 1062 "./weaver-memory-manager.tex"
+
+{
+int offset;
+size_t r;
+void*new_free;
+struct arena_header*head= (struct arena_header*)arena;
+for(;;){
+r= load_size(&(head->remaining_space));
+if(r<t){
+p= NULL;
+break;
+}
+if(right){
+old_free= load_pointer(&(head->right_free));
+p= ((char*)old_free)-t+1;
+/*36:*/
+#line 1010 "./weaver-memory-manager.tex"
+
+offset= 0;
+if(a> 1){
+void*new_p= (void*)(((uintptr_t)p)&(~((uintptr_t)a-1)));
+offset= ((char*)p)-((char*)new_p);
+p= new_p;
+}
+/*:36*/
+#line 1077 "./weaver-memory-manager.tex"
+
+new_free= (char*)p-1;
+}
+else{
+old_free= load_pointer(&(head->left_free));
+p= old_free;
+/*34:*/
+#line 981 "./weaver-memory-manager.tex"
+
+offset= 0;
+if(a> 1){
+void*new_p= ((char*)p)+(a-1);
+new_p= (void*)(((uintptr_t)new_p)&(~((uintptr_t)a-1)));
+offset= ((char*)new_p)-((char*)p);
+p= new_p;
+}
+/*:34*/
+#line 1083 "./weaver-memory-manager.tex"
+
+new_free= (char*)p+t;
+}
+if(r<t+offset){
+p= NULL;
+break;
+}
+if(!cas_size(&(head->remaining_space),r,r-t-offset))
+continue;
+if((head->flags&W_GROWABLE)&&
+!grow_stack(head,right,(right)?((char*)p):((char*)new_free))){
+add_size(&(head->remaining_space),t+offset);
+p= NULL;
+break;
+}
+if(cas_pointer((right)?(&(head->right_free)):(&(head->left_free)),
+old_free,new_free))
+break;
+add_size(&(head->remaining_space),t+offset);
+}
+if(p!=NULL&&offset!=0)
+add_size(&(head->alignment_padding),offset);
+}
+/*:37*/
+#line 2932 "./weaver-memory-manager.tex"
+
+}
+/*65:*/
+#line 1781 "./weaver-memory-manager.tex"
+
+if(p==NULL&&(header->flags&W_CHAINED))
+p= chunk_alloc(header,a,right,t,&old_free);
+/*:65*/
+#line 2934 "./weaver-memory-manager.tex"
+
+d= (struct destructor*)p;
+if(d!=NULL){
+d->function= destructor;
+d->object= object;
+if(right){
+d->previous= header->right_destructors;
+header->right_destructors= d;
+}
+else{
+d->previous= header->left_destructors;
+header->left_destructors= d;
+}
+}
+/*24:*/
+#line 611 "./weaver-memory-manager.tex"
+
+#if defined(__unix__) || defined(__APPLE__)
+pthread_mutex_unlock((pthread_mutex_t*)mutex);
+#endif
+#if defined(_WIN32)
+LeaveCriticalSection((CRITICAL_SECTION*)mutex);
+#endif
+/*:24*/
+#line 2948 "./weaver-memory-manager.tex"
+
+return(d!=NULL);
+}
+/*:105*/
+#line 5540 "./weaver-memory-manager.tex"
+
+/*110:*/
+#line 3100 "./weaver-memory-manager.tex"
+
+bool _Wcreate_frame_ring(struct _Wframe_ring*ring,unsigned n,
+size_t size,unsigned flags){
+unsigned i;
+if(n==0||n> W_MAX_FRAMES)
+return false;
+for(i= 0;i<n;i++){
+ring->arena[i]= _Wcreate_arena_flags(size,flags);
+if(ring->arena[i]==NULL){
+while(i> 0){
+i--;
+_Wdestroy_arena(ring->arena[i]);
+}
+return false;
+}
+}
+ring->number_of_frames= n;
+ring->frame= 0;
+return true;
+}
+/*:110*/
+#line 5541 "./weaver-memory-manager.tex"
+
+/*114:*/
+#line 3179 "./weaver-memory-manager.tex"
+
+bool _Wdestroy_frame_ring(struct _Wframe_ring*ring){
+unsigned i;
+bool ret= true;
+for(i= 0;i<ring->number_of_frames;i++){
+void*arena= ring->arena[i];
+/*111:*/
+#line 3130 "./weaver-memory-manager.tex"
+
+{
+struct arena_header*header= (struct arena_header*)arena;
+void*mutex= (void*)&(header->mutex);
+/*142:*/
+#line 3966 "./weaver-memory-manager.tex"
+
+#if defined(W_LOCK_STATS)
+lock_mutex(mutex,__func__,-1);
+#else
+/*23:*/
+#line 591 "./weaver-memory-manager.tex"
+
+#if defined(W_LOCK_STATS)
+lock_mutex(mutex,__func__,right);
+#else
+#if defined(__unix__) || defined(__APPLE__)
+if(pthread_mutex_lock((pthread_mutex_t*)mutex)==EOWNERDEAD){
+/*171:*/
+#line 4716 "./weaver-memory-manager.tex"
+
+#if defined(__linux__)
+pthread_mutex_consistent((pthread_mutex_t*)mutex);
+#endif
+/*:171*/
+#line 597 "./weaver-memory-manager.tex"
+
+}
+#endif
+#if defined(_WIN32)
+EnterCriticalSection((CRITICAL_SECTION*)mutex);
+#endif
+#endif
+/*:23*/
+#line 3970 "./weaver-memory-manager.tex"
+
+#endif
+/*:142*/
+#line 3134 "./weaver-memory-manager.tex"
+
+header->left_point= NULL;
+header->right_point= NULL;
+/*24:*/
+#line 611 "./weaver-memory-manager.tex"
+
+#if defined(__unix__) || defined(__APPLE__)
+pthread_mutex_unlock((pthread_mutex_t*)mutex);
+#endif
+#if defined(_WIN32)
+LeaveCriticalSection((CRITICAL_SECTION*)mutex);
+#endif
+/*:24*/
+#line 3137 "./weaver-memory-manager.tex"
+
+_Wtrash(arena,0);
+_Wtrash(arena,1);
+}
+/*:111*/
+#line 3185 "./weaver-memory-manager.tex"
+
+if(!_Wdestroy_arena(arena))
+ret= false;
+}
+return ret;
+}
+/*:114*/
+#line 5542 "./weaver-memory-manager.tex"
+
+/*112:*/
+#line 3152 "./weaver-memory-manager.tex"
+
+void*_Wbegin_frame(struct _Wframe_ring*ring){
+size_t frame= load_size(&(ring->frame))+1;
+void*arena= ring->arena[frame%ring->number_of_frames];
+/*111:*/
+#line 3130 "./weaver-memory-manager.tex"
+
+{
+struct arena_header*header= (struct arena_header*)arena;
+void*mutex= (void*)&(header->mutex);
+/*142:*/
+#line 3966 "./weaver-memory-manager.tex"
+
+#if defined(W_LOCK_STATS)
+lock_mutex(mutex,__func__,-1);
+#else
+/*23:*/
+#line 591 "./weaver-memory-manager.tex"
+
+#if defined(W_LOCK_STATS)
+lock_mutex(mutex,__func__,right);
+#else
+#if defined(__unix__) || defined(__APPLE__)
+if(pthread_mutex_lock((pthread_mutex_t*)mutex)==EOWNERDEAD){
+/*171:*/
+#line 4716 "./weaver-memory-manager.tex"
+
+#if defined(__linux__)
+pthread_mutex_consistent((pthread_mutex_t*)mutex);
+#endif
+/*:171*/
+#line 597 "./weaver-memory-manager.tex"
+
+}
+#endif
+#if defined(_WIN32)
+EnterCriticalSection((CRITICAL_SECTION*)mutex);
+#endif
+#endif
+/*:23*/
+#line 3970 "./weaver-memory-manager.tex"
+
+#endif
+/*:142*/
+#line 3134 "./weaver-memory-manager.tex"
+
+header->left_point= NULL;
+header->right_point= NULL;
+/*24:*/
+#line 611 "./weaver-memory-manager.tex"
+
+#if defined(__unix__) || defined(__APPLE__)
+pthread_mutex_unlock((pthread_mutex_t*)mutex);
+#endif
+#if defined(_WIN32)
+LeaveCriticalSection((CRITICAL_SECTION*)mutex);
+#endif
+/*:24*/
+#line 3137 "./weaver-memory-manager.tex"
+
+_Wtrash(arena,0);
+_Wtrash(arena,1);
+}
+/*:111*/
+#line 3156 "./weaver-memory-manager.tex"
+
+add_size(&(ring->frame),1);
+return arena;
+}
+/*:112*/
+#line 5543 "./weaver-memory-manager.tex"
+
+/*113:*/
+#line 3166 "./weaver-memory-manager.tex"
+
+void*_Wframe_arena(struct _Wframe_ring*ring){
+size_t frame= load_size(&(ring->frame));
+return ring->arena[frame%ring->number_of_frames];
+}
+/*:113*/
+#line 5544 "./weaver-memory-manager.tex"
+
+/*117:*/
+#line 3262 "./weaver-memory-manager.tex"
+
+void*_Wcreate_pool(void*arena,int right,unsigned a,
+unsigned number_of_classes,const size_t*sizes,
+const size_t*counts){
+struct pool_header*pool;
+size_t header_size,total,size;
+char*p;
+unsigned i;
+if(a<sizeof(void*))
+a= sizeof(void*);
+header_size= sizeof(struct pool_header)+
+number_of_classes*sizeof(struct pool_class);
+header_size= (header_size+(a-1))&~((size_t)a-1);
+total= header_size;
+for(i= 0;i<number_of_classes;i++){
+if(i> 0&&sizes[i]<=sizes[i-1])
+return NULL;
+size= (sizes[i]+(a-1))&~((size_t)a-1);
+total+= size*counts[i];
+}
+pool= (struct pool_header*)_Walloc(arena,a,right,total);
+if(pool==NULL)
+return NULL;
+pool->number_of_classes= number_of_classes;
+p= ((char*)pool)+header_size;
+for(i= 0;i<number_of_classes;i++){
+struct pool_class*c= &(pool->classes[i]);
+c->size= (sizes[i]+(a-1))&~((size_t)a-1);
+c->begin= p;
+c->next= p;
+c->end= p+c->size*counts[i];
+c->free= NULL;
+c->remote_free= NULL;
+p= c->end;
+}
+return pool;
+}
+/*:117*/
+#line 5545 "./weaver-memory-manager.tex"
+
+/*118:*/
+#line 3312 "./weaver-memory-manager.tex"
+
+void*_Wpool_alloc(void*pool,size_t t){
+struct pool_header*header= (struct pool_header*)pool;
+unsigned i;
+for(i= 0;i<header->number_of_classes;i++){
+struct pool_class*c= &(header->classes[i]);
+void*p;
+if(c->size<t)
+continue;
+p= c->free;
+if(p==NULL)
+p= exchange_pointer(&(c->remote_free),NULL);
+if(p!=NULL){
+c->free= *((void**)p);
+return p;
+}
+if(c->next<c->end){
+p= c->next;
+c->next+= c->size;
+return p;
+}
+}
+return NULL;
+}
+/*:118*/
+#line 5546 "./weaver-memory-manager.tex"
+
+/*119:*/
+#line 3344 "./weaver-memory-manager.tex"
+
+void _Wpool_free(void*pool,void*p){
+struct pool_header*header= (struct pool_header*)pool;
+unsigned i;
+for(i= 0;i<header->number_of_classes;i++){
+struct pool_class*c= &(header->classes[i]);
+if((char*)p>=c->begin&&(char*)p<c->end){
+*((void**)p)= c->free;
+c->free= p;
+return;
+}
+}
+}
+/*:119*/
+#line 5547 "./weaver-memory-manager.tex"
+
+/*120:*/
+#line 3365 "./weaver-memory-manager.tex"
+
+void _Wpool_free_remote(void*pool,void*p){
+struct pool_header*header= (struct pool_header*)pool;
+unsigned i;
+for(i= 0;i<header->number_of_classes;i++){
+struct pool_class*c= &(header->classes[i]);
+if((char*)p>=c->begin&&(char*)p<c->end){
+void*old;
+do{
+old= load_pointer(&(c->remote_free));
+*((void**)p)= old;
+}while(!cas_pointer(&(c->remote_free),old,p));
+return;
+}
+}
+}
+/*:120*/
+#line 5548 "./weaver-memory-manager.tex"
+
+/*124:*/
+#line 3478 "./weaver-memory-manager.tex"
+
+void*_Wrealloc(void*arena,unsigned a,int right,void*ptr,
+size_t old_size,size_t new_size){
+struct arena_header*header= (struct arena_header*)arena;
+void**free_pointer;
+char*old_free,*new_free,*p;
+size_t r,d;
+bool moved;
+void*q;
+if(ptr==NULL)
+return _Walloc(arena,a,right,new_size);
+if(new_size<old_size)
+record_high_water(header,right);
+if(right){
+free_pointer= &(header->right_free);
+old_free= ((char*)ptr)-1;
+p= ((char*)ptr)+old_size-new_size;
+if(a> 1)
+p= (char*)(((uintptr_t)p)&(~((uintptr_t)a-1)));
+new_free= p-1;
+if(p>=(char*)ptr){
+if(load_pointer(free_pointer)!=old_free)
+return ptr;
+memmove(p,ptr,new_size);
+if(cas_pointer(free_pointer,old_free,new_free))
+add_size(&(header->remaining_space),p-(char*)ptr);
+/*164:*/
+#line 4555 "./weaver-memory-manager.tex"
+
+#if defined(W_TRACE)
+{
+struct _Wtrace_event*event= trace_event(W_TRACE_REALLOC,arena,right,
+new_size,a,ptr);
+if(event!=NULL)
+event->previous_size= old_size;
+}
+#endif
+/*:164*/
+#line 3504 "./weaver-memory-manager.tex"
+
+return p;
+}
+d= ((char*)ptr)-p;
+/*123:*/
+#line 3445 "./weaver-memory-manager.tex"
+
+moved= false;
+r= load_size(&(header->remaining_space));
+while(r>=d&&!cas_size(&(header->remaining_space),r,r-d))
+r= load_size(&(header->remaining_space));
+if(r>=d){
+if((!(header->flags&W_GROWABLE)||
+grow_stack(header,right,(right)?(new_free+1):(new_free)))&&
+cas_pointer(free_pointer,old_free,new_free))
+moved= true;
+else
+add_size(&(header->remaining_space),d);
+}
+/*:123*/
+#line 3508 "./weaver-memory-manager.tex"
+
+if(moved){
+memmove(p,ptr,old_size);
+/*164:*/
+#line 4555 "./weaver-memory-manager.tex"
+
+#if defined(W_TRACE)
+{
+struct _Wtrace_event*event= trace_event(W_TRACE_REALLOC,arena,right,
+new_size,a,ptr);
+if(event!=NULL)
+event->previous_size= old_size;
+}
+#endif
+/*:164*/
+#line 3511 "./weaver-memory-manager.tex"
+
+return p;
+}
+}
+else{
+free_pointer= &(header->left_free);
+old_free= ((char*)ptr)+old_size;
+new_free= ((char*)ptr)+new_size;
+if(new_size<=old_size){
+if(cas_pointer(free_pointer,old_free,new_free)){
+add_size(&(header->remaining_space),old_size-new_size);
+/*164:*/
+#line 4555 "./weaver-memory-manager.tex"
+
+#if defined(W_TRACE)
+{
+struct _Wtrace_event*event= trace_event(W_TRACE_REALLOC,arena,right,
+new_size,a,ptr);
+if(event!=NULL)
+event->previous_size= old_size;
+}
+#endif
+/*:164*/
+#line 3522 "./weaver-memory-manager.tex"
+
+}
+return ptr;
+}
+d= new_size-old_size;
+/*123:*/
+#line 3445 "./weaver-memory-manager.tex"
+
+moved= false;
+r= load_size(&(header->remaining_space));
+while(r>=d&&!cas_size(&(header->remaining_space),r,r-d))
+r= load_size(&(header->remaining_space));
+if(r>=d){
+if((!(header->flags&W_GROWABLE)||
+grow_stack(header,right,(right)?(new_free+1):(new_free)))&&
+cas_pointer(free_pointer,old_free,new_free))
+moved= true;
+else
+add_size(&(header->remaining_space),d);
+}
+/*:123*/
+#line 3527 "./weaver-memory-manager.tex"
+
+if(moved){
+/*164:*/
+#line 4555 "./weaver-memory-manager.tex"
+
+#if defined(W_TRACE)
+{
+struct _Wtrace_event*event= trace_event(W_TRACE_REALLOC,arena,right,
+new_size,a,ptr);
+if(event!=NULL)
+event->previous_size= old_size;
+}
+#endif
+/*:164*/
+#line 3529 "./weaver-memory-manager.tex"
+
+return ptr;
+}
+}
+q= _Walloc(arena,a,right,new_size);
+if(q!=NULL)
+memcpy(q,ptr,(old_size<new_size)?(old_size):(new_size));
+return q;
+}
+/*:124*/
+#line 5549 "./weaver-memory-manager.tex"
+
+/*122:*/
+#line 3419 "./weaver-memory-manager.tex"
+
+bool _Wpop(void*arena,int right,void*p,size_t t){
+struct arena_header*header= (struct arena_header*)arena;
+bool popped;
+record_high_water(header,right);
+if(right)
+popped= cas_pointer(&(header->right_free),((char*)p)-1,
+((char*)p)+t-1);
+else
+popped= cas_pointer(&(header->left_free),((char*)p)+t,p);
+if(popped)
+add_size(&(header->remaining_space),t);
+/*163:*/
+#line 4547 "./weaver-memory-manager.tex"
+
+#if defined(W_TRACE)
+trace_event(W_TRACE_POP,arena,right,t,0,(popped)?(p):(NULL));
+#endif
+/*:163*/
+#line 3431 "./weaver-memory-manager.tex"
+
+return popped;
+}
+/*:122*/
+#line 5550 "./weaver-memory-manager.tex"
+
+/*127:*/
+#line 3589 "./weaver-memory-manager.tex"
+
+void _Wset_mark(void*arena,int right,struct _Wmark*mark){
+struct arena_header*header= (struct arena_header*)arena;
+void*mutex= (void*)&(header->mutex);
+/*23:*/
+#line 591 "./weaver-memory-manager.tex"
+
+#if defined(W_LOCK_STATS)
+lock_mutex(mutex,__func__,right);
+#else
+#if defined(__unix__) || defined(__APPLE__)
+if(pthread_mutex_lock((pthread_mutex_t*)mutex)==EOWNERDEAD){
+/*171:*/
+#line 4716 "./weaver-memory-manager.tex"
+
+#if defined(__linux__)
+pthread_mutex_consistent((pthread_mutex_t*)mutex);
+#endif
+/*:171*/
+#line 597 "./weaver-memory-manager.tex"
+
+}
+#endif
+#if defined(_WIN32)
+EnterCriticalSection((CRITICAL_SECTION*)mutex);
+#endif
+#endif
+/*:23*/
+#line 3593 "./weaver-memory-manager.tex"
+
+if(/*63:*/
+#line 1755 "./weaver-memory-manager.tex"
+
+(!(header->flags&W_CHAINED)||
+load_pointer((right)?(&(header->right_chunk)):
+(&(header->left_chunk)))==NULL)
+/*:63*/
+#line 3594 "./weaver-memory-manager.tex"
+)
+mark->free= load_pointer((right)?(&(header->right_free)):
+(&(header->left_free)));
+else
+mark->free= ((struct chunk_header*)
+((right)?(header->right_chunk):
+(header->left_chunk)))->free;
+if(right){
+mark->memory_point= header->right_point;
+mark->destructors= header->right_destructors;
+}
+else{
+mark->memory_point= header->left_point;
+mark->destructors= header->left_destructors;
+}
+mark->right= right;
+/*24:*/
+#line 611 "./weaver-memory-manager.tex"
+
+#if defined(__unix__) || defined(__APPLE__)
+pthread_mutex_unlock((pthread_mutex_t*)mutex);
+#endif
+#if defined(_WIN32)
+LeaveCriticalSection((CRITICAL_SECTION*)mutex);
+#endif
+/*:24*/
+#line 3610 "./weaver-memory-manager.tex"
+
+/*160:*/
+#line 4521 "./weaver-memory-manager.tex"
+
+#if defined(W_TRACE)
+trace_event(W_TRACE_MARK,arena,right,0,0,mark->free);
+#endif
+/*:160*/
+#line 3611 "./weaver-memory-manager.tex"
+
+}
+/*:127*/
+#line 5551 "./weaver-memory-manager.tex"
+
+/*130:*/
+#line 3700 "./weaver-memory-manager.tex"
+
+bool _Wtrash_to(void*arena,struct _Wmark*mark){
+struct arena_header*head= (struct arena_header*)arena;
+void*mutex= (void*)&(head->mutex);
+struct memory_point mark_point,*point= &mark_point;
+void*old_free,*new_free;
+int right= mark->right;
+bool restored;
+mark_point.free= mark->free;
+mark_point.last_memory_point= 
+(struct memory_point*)mark->memory_point;
+mark_point.destructors= (struct destructor*)mark->destructors;
+/*23:*/
+#line 591 "./weaver-memory-manager.tex"
+
+#if defined(W_LOCK_STATS)
+lock_mutex(mutex,__func__,right);
+#else
+#if defined(__unix__) || defined(__APPLE__)
+if(pthread_mutex_lock((pthread_mutex_t*)mutex)==EOWNERDEAD){
+/*171:*/
+#line 4716 "./weaver-memory-manager.tex"
+
+#if defined(__linux__)
+pthread_mutex_consistent((pthread_mutex_t*)mutex);
+#endif
+/*:171*/
+#line 597 "./weaver-memory-manager.tex"
+
+}
+#endif
+#if defined(_WIN32)
+EnterCriticalSection((CRITICAL_SECTION*)mutex);
+#endif
+#endif
+/*:23*/
+#line 3712 "./weaver-memory-manager.tex"
+
+restored= !stale_mark(head,mark);
+if(restored){
+new_free= point->free;
+/*128:*/
+#line 3626 "./weaver-memory-manager.tex"
+
+record_high_water(head,right);
+/*106:*/
+#line 2971 "./weaver-memory-manager.tex"
+
+{
+struct destructor*d,*last;
+last= (point==NULL)?(NULL):(point->destructors);
+d= (right)?(head->right_destructors):(head->left_destructors);
+while(d!=last){
+if(right)
+head->right_destructors= last;
+else
+head->left_destructors= last;
+/*24:*/
+#line 611 "./weaver-memory-manager.tex"
+
+#if defined(__unix__) || defined(__APPLE__)
+pthread_mutex_unlock((pthread_mutex_t*)mutex);
+#endif
+#if defined(_WIN32)
+LeaveCriticalSection((CRITICAL_SECTION*)mutex);
+#endif
+/*:24*/
+#line 2981 "./weaver-memory-manager.tex"
+
+while(d!=last){
+d->function(d->object);
+d= d->previous;
+}
+/*23:*/
+#line 591 "./weaver-memory-manager.tex"
+
+#if defined(W_LOCK_STATS)
+lock_mutex(mutex,__func__,right);
+#else
+#if defined(__unix__) || defined(__APPLE__)
+if(pthread_mutex_lock((pthread_mutex_t*)mutex)==EOWNERDEAD){
+/*171:*/
+#line 4716 "./weaver-memory-manager.tex"
+
+#if defined(__linux__)
+pthread_mutex_consistent((pthread_mutex_t*)mutex);
+#endif
+/*:171*/
+#line 597 "./weaver-memory-manager.tex"
+
+}
+#endif
+#if defined(_WIN32)
+EnterCriticalSection((CRITICAL_SECTION*)mutex);
+#endif
+#endif
+/*:23*/
+#line 2986 "./weaver-memory-manager.tex"
+
+d= (right)?(head->right_destructors):(head->left_destructors);
+}
+}
+/*:106*/
+#line 3628 "./weaver-memory-manager.tex"
+
+if(right)
+head->right_point= (point==NULL)?(NULL):(point->last_memory_point);
+else
+head->left_point= (point==NULL)?(NULL):(point->last_memory_point);
+/*47:*/
+#line 1380 "./weaver-memory-manager.tex"
+
+if(right)
+add_size(&(head->right_generation),1);
+else
+add_size(&(head->left_generation),1);
+/*:47*/
+#line 3633 "./weaver-memory-manager.tex"
+
+/*69:*/
+#line 1906 "./weaver-memory-manager.tex"
+
+if(head->flags&W_CHAINED){
+void**current= (right)?(&(head->right_chunk)):(&(head->left_chunk));
+struct chunk_header*chunk;
+while(*current!=NULL){
+chunk= (struct chunk_header*)*current;
+if((char*)new_free>=((char*)chunk)+sizeof(struct chunk_header)&&
+(char*)new_free<=((char*)chunk)+chunk->size){
+chunk->free= (char*)new_free;
+new_free= NULL;
+break;
+}
+exchange_pointer(current,chunk->previous);
+release_chunk(head,chunk);
+}
+}
+/*:69*/
+#line 3634 "./weaver-memory-manager.tex"
+
+if(new_free!=NULL){
+/*76:*/
+#line 2058 "./weaver-memory-manager.tex"
+
+{
+char*top;
+if(right){
+top= ((char*)load_pointer(&(head->right_free)))+1;
+if((size_t)(((char*)new_free)+1-top)> head->trim_threshold)
+release_pages(head,top,
+((char*)new_free)+1-head->trim_threshold);
+}
+else{
+top= (char*)load_pointer(&(head->left_free));
+if((size_t)(top-((char*)new_free))> head->trim_threshold)
+release_pages(head,((char*)new_free)+head->trim_threshold,
+top);
+}
+}
+/*:76*/
+#line 3636 "./weaver-memory-manager.tex"
+
+/*40:*/
+#line 1175 "./weaver-memory-manager.tex"
+
+{
+struct arena_header*header= arena;
+if(right){
+old_free= exchange_pointer(&(header->right_free),new_free);
+add_size(&(header->remaining_space),
+((char*)new_free)-((char*)old_free));
+}
+else{
+old_free= exchange_pointer(&(header->left_free),new_free);
+add_size(&(header->remaining_space),
+((char*)old_free)-((char*)new_free));
+}
+}
+/*:40*/
+#line 3637 "./weaver-memory-manager.tex"
+
+}
+/*:128*/
+#line 3716 "./weaver-memory-manager.tex"
+
+}
+/*24:*/
+#line 611 "./weaver-memory-manager.tex"
+
+#if defined(__unix__) || defined(__APPLE__)
+pthread_mutex_unlock((pthread_mutex_t*)mutex);
+#endif
+#if defined(_WIN32)
+LeaveCriticalSection((CRITICAL_SECTION*)mutex);
+#endif
+/*:24*/
+#line 3718 "./weaver-memory-manager.tex"
+
+/*161:*/
+#line 4529 "./weaver-memory-manager.tex"
+
+#if defined(W_TRACE)
+trace_event(W_TRACE_TRASH_TO,arena,right,0,0,
+(restored)?(mark->free):(NULL));
+#endif
+/*:161*/
+#line 3719 "./weaver-memory-manager.tex"
+
+return restored;
+}
+/*:130*/
+#line 5552 "./weaver-memory-manager.tex"
+
+/*131:*/
+#line 3732 "./weaver-memory-manager.tex"
+
+bool _Wcommit(void*arena,int right){
+struct arena_header*header= (struct arena_header*)arena;
+void*mutex= (void*)&(header->mutex);
+struct memory_point*point;
+/*23:*/
+#line 591 "./weaver-memory-manager.tex"
+
+#if defined(W_LOCK_STATS)
+lock_mutex(mutex,__func__,right);
+#else
+#if defined(__unix__) || defined(__APPLE__)
+if(pthread_mutex_lock((pthread_mutex_t*)mutex)==EOWNERDEAD){
+/*171:*/
+#line 4716 "./weaver-memory-manager.tex"
+
+#if defined(__linux__)
+pthread_mutex_consistent((pthread_mutex_t*)mutex);
+#endif
+/*:171*/
+#line 597 "./weaver-memory-manager.tex"
+
+}
+#endif
+#if defined(_WIN32)
+EnterCriticalSection((CRITICAL_SECTION*)mutex);
+#endif
+#endif
+/*:23*/
+#line 3737 "./weaver-memory-manager.tex"
+
+point= (right)?(header->right_point):(header->left_point);
+if(point!=NULL){
+if(right)
+header->right_point= point->last_memory_point;
+else
+header->left_point= point->last_memory_point;
+}
+/*24:*/
+#line 611 "./weaver-memory-manager.tex"
+
+#if defined(__unix__) || defined(__APPLE__)
+pthread_mutex_unlock((pthread_mutex_t*)mutex);
+#endif
+#if defined(_WIN32)
+LeaveCriticalSection((CRITICAL_SECTION*)mutex);
+#endif
+/*:24*/
+#line 3745 "./weaver-memory-manager.tex"
+
+/*162:*/
+#line 4538 "./weaver-memory-manager.tex"
+
+#if defined(W_TRACE)
+trace_event(W_TRACE_COMMIT,arena,right,0,0,
+(point==NULL)?(NULL):(arena));
+#endif
+/*:162*/
+#line 3746 "./weaver-memory-manager.tex"
+
+return(point!=NULL);
+}
+/*:131*/
+#line 5553 "./weaver-memory-manager.tex"
+
+/*138:*/
+#line 3883 "./weaver-memory-manager.tex"
+
+void _Wget_stats(void*arena,struct _Wstats*stats){
+struct arena_header*header= (struct arena_header*)arena;
+void*mutex= (void*)&(header->mutex);
+bool chained= ((header->flags&W_CHAINED)!=0);
+if(chained){
+/*143:*/
+#line 3981 "./weaver-memory-manager.tex"
+
+#if defined(__unix__) || defined(__APPLE__)
+if(pthread_mutex_lock((pthread_mutex_t*)mutex)==EOWNERDEAD){
+/*171:*/
+#line 4716 "./weaver-memory-manager.tex"
+
+#if defined(__linux__)
+pthread_mutex_consistent((pthread_mutex_t*)mutex);
+#endif
+/*:171*/
+#line 3984 "./weaver-memory-manager.tex"
+
+}
+#endif
+#if defined(_WIN32)
+EnterCriticalSection((CRITICAL_SECTION*)mutex);
+#endif
+/*:143*/
+#line 3889 "./weaver-memory-manager.tex"
+
+}
+stats->left_used= record_high_water(header,0);
+stats->right_used= record_high_water(header,1);
+if(chained){
+/*24:*/
+#line 611 "./weaver-memory-manager.tex"
+
+#if defined(__unix__) || defined(__APPLE__)
+pthread_mutex_unlock((pthread_mutex_t*)mutex);
+#endif
+#if defined(_WIN32)
+LeaveCriticalSection((CRITICAL_SECTION*)mutex);
+#endif
+/*:24*/
+#line 3894 "./weaver-memory-manager.tex"
+
+}
+stats->total_size= header->total_size;
+stats->remaining_space= load_size(&(header->remaining_space));
+stats->left_high_water= load_size(&(header->left_high_water));
+stats->right_high_water= load_size(&(header->right_high_water));
+stats->allocations= load_size(&(header->allocations));
+stats->memory_points= load_size(&(header->memory_points));
+stats->alignment_padding= load_size(&(header->alignment_padding));
+stats->failed_allocations= load_size(&(header->failed_allocations));
+}
+/*:138*/
+#line 5554 "./weaver-memory-manager.tex"
+
+/*147:*/
+#line 4102 "./weaver-memory-manager.tex"
+
+bool _Wget_lock_stats(void*arena,struct _Wlock_stats*stats){
+#if defined(W_LOCK_STATS)
+struct arena_header*header= (struct arena_header*)arena;
+void*mutex= (void*)&(header->mutex);
+/*142:*/
+#line 3966 "./weaver-memory-manager.tex"
+
+#if defined(W_LOCK_STATS)
+lock_mutex(mutex,__func__,-1);
+#else
+/*23:*/
+#line 591 "./weaver-memory-manager.tex"
+
+#if defined(W_LOCK_STATS)
+lock_mutex(mutex,__func__,right);
+#else
+#if defined(__unix__) || defined(__APPLE__)
+if(pthread_mutex_lock((pthread_mutex_t*)mutex)==EOWNERDEAD){
+/*171:*/
+#line 4716 "./weaver-memory-manager.tex"
+
+#if defined(__linux__)
+pthread_mutex_consistent((pthread_mutex_t*)mutex);
+#endif
+/*:171*/
+#line 597 "./weaver-memory-manager.tex"
+
+}
+#endif
+#if defined(_WIN32)
 EnterCriticalSection((CRITICAL_SECTION*)mutex);
 #endif
-/*:23*/
-#line 1012 "./weaver-memory-manager.tex"
+#endif
+/*:23*/
+#line 3970 "./weaver-memory-manager.tex"
+
+#endif
+/*:142*/
+#line 4107 "./weaver-memory-manager.tex"
+
+stats->acquisitions= header->lock_acquisitions;
+stats->contended_acquisitions= header->contended_acquisitions;
+stats->wait_time= header->wait_time;
+stats->longest_wait= header->longest_wait;
+stats->longest_wait_operation= 
+(header->longest_wait_operation<0)?(NULL):
+(lock_operations[header->longest_wait_operation]);
+stats->longest_wait_side= header->longest_wait_side;
+/*24:*/
+#line 611 "./weaver-memory-manager.tex"
+
+#if defined(__unix__) || defined(__APPLE__)
+pthread_mutex_unlock((pthread_mutex_t*)mutex);
+#endif
+#if defined(_WIN32)
+LeaveCriticalSection((CRITICAL_SECTION*)mutex);
+#endif
+/*:24*/
+#line 4116 "./weaver-memory-manager.tex"
+
+return true;
+#else
+stats->acquisitions= stats->contended_acquisitions= 0;
+stats->wait_time= stats->longest_wait= 0;
+stats->longest_wait_operation= NULL;
+stats->longest_wait_side= -1;
+return false;
+#endif
+}
+/*:147*/
+#line 5555 "./weaver-memory-manager.tex"
+
+/*153:*/
+#line 4400 "./weaver-memory-manager.tex"
+
+bool _Wbegin_trace(const char*filename){
+#if defined(W_TRACE)
+FILE*file= NULL;
+lock_trace();
+if(trace_file==NULL){
+file= fopen(filename,"wb");
+if(file!=NULL)
+exchange_pointer((void**)&trace_file,file);
+}
+unlock_trace();
+return(file!=NULL);
+#else
+return false;
+#endif
+}
+void _Wflush_trace(void){
+#if defined(W_TRACE)
+flush_trace_buffer();
+#endif
+}
+bool _Wend_trace(void){
+#if defined(W_TRACE)
+FILE*file;
+struct trace_buffer**buffer;
+lock_trace();
+buffer= &trace_buffers;
+while(*buffer!=NULL){
+struct trace_buffer*unused= *buffer;
+write_trace_buffer(unused);
+if(unused->in_use)
+buffer= &(unused->next);
+else{
+*buffer= unused->next;
+free(unused);
+}
+}
+file= (FILE*)exchange_pointer((void**)&trace_file,NULL);
+unlock_trace();
+return(file!=NULL&&fclose(file)==0);
+#else
+return false;
+#endif
+}
+/*:153*/
+#line 5556 "./weaver-memory-manager.tex"
+
+/*169:*/
+#line 4638 "./weaver-memory-manager.tex"
+
+void*_Wcreate_shared_arena(const char*name,size_t t,int*descriptor){
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+bool error= false;
+void*arena= NULL;
+int fd= -1;
+unsigned flags= W_SHARED;
+size_t p,M,header_size= sizeof(struct arena_header);
+/*13:*/
+#line 425 "./weaver-memory-manager.tex"
+
+#if defined(__unix__)
+p= sysconf(_SC_PAGESIZE);
+#endif
+/*:13*//*14:*/
+#line 440 "./weaver-memory-manager.tex"
+
+#if defined(__APPLE__)
+p= getpagesize();
+#endif
+/*:14*//*16:*/
+#line 464 "./weaver-memory-manager.tex"
+
+#if defined(_WIN32)
+{
+SYSTEM_INFO info;
+GetSystemInfo(&info);
+p= info.dwPageSize;
+}
+#endif
+/*:16*//*18:*/
+#line 496 "./weaver-memory-manager.tex"
+
+#if defined(__EMSCRIPTEN__)
+p= 64*1024;
+#endif
+/*:18*/
+#line 4646 "./weaver-memory-manager.tex"
+
+M= (((t-1)/p)+1)*p;
+if(M<header_size)
+M= (((header_size-1)/p)+1)*p;
+if(name!=NULL)
+fd= shm_open(name,O_RDWR|O_CREAT|O_EXCL,S_IRUSR|S_IWUSR);
+#if defined(SYS_memfd_create)
+else
+fd= syscall(SYS_memfd_create,"weaver-arena",0);
+#endif
+if(fd==-1)
+return NULL;
+if(ftruncate(fd,M)==0){
+arena= mmap(NULL,M,PROT_READ|PROT_WRITE,MAP_SHARED,fd,0);
+if(arena==MAP_FAILED)
+arena= NULL;
+}
+if(arena!=NULL){
+/*30:*/
+#line 793 "./weaver-memory-manager.tex"
+
+{
+struct arena_header*header= (struct arena_header*)arena;
+header->right_free= ((char*)header)+M-1;
+header->left_free= ((char*)header)+sizeof(struct arena_header);
+header->remaining_space= M-sizeof(struct arena_header);
+header->total_size= M;
+header->left_point= NULL;
+header->right_point= NULL;
+/*46:*/
+#line 1369 "./weaver-memory-manager.tex"
+
+header->left_generation= 0;
+header->right_generation= 0;
+/*:46*//*57:*/
+#line 1607 "./weaver-memory-manager.tex"
+
+header->flags= flags;
+header->page_size= p;
+if(flags&W_GROWABLE){
+header->left_committed= ((char*)arena)+
+(((sizeof(struct arena_header)-1)/p)+1)*p;
+header->right_committed= ((char*)arena)+M-p;
+}
+else{
+header->left_committed= ((char*)arena)+M;
+header->right_committed= arena;
+}
+/*:57*//*62:*/
+#line 1741 "./weaver-memory-manager.tex"
+
+header->left_chunk= NULL;
+header->right_chunk= NULL;
+header->chunk_cache= NULL;
+header->cached_chunks= 0;
+/*:62*//*73:*/
+#line 2020 "./weaver-memory-manager.tex"
+
+header->trim_threshold= SIZE_MAX;
+/*:73*//*103:*/
+#line 2898 "./weaver-memory-manager.tex"
+
+header->left_destructors= NULL;
+header->right_destructors= NULL;
+/*:103*//*135:*/
+#line 3805 "./weaver-memory-manager.tex"
+
+header->allocations= 0;
+header->alignment_padding= 0;
+header->left_high_water= 0;
+header->right_high_water= 0;
+header->memory_points= 0;
+header->failed_allocations= 0;
+/*:135*//*141:*/
+#line 3947 "./weaver-memory-manager.tex"
+
+#if defined(W_LOCK_STATS)
+header->lock_acquisitions= 0;
+header->contended_acquisitions= 0;
+header->wait_time= 0;
+header->longest_wait= 0;
+header->longest_wait_operation= -1;
+header->longest_wait_side= -1;
+#endif
+/*:141*//*168:*/
+#line 4618 "./weaver-memory-manager.tex"
+
+header->base= arena;
+/*:168*//*177:*/
+#line 4855 "./weaver-memory-manager.tex"
+
+header->signature= W_SIGNATURE;
+/*:177*//*189:*/
+#line 5155 "./weaver-memory-manager.tex"
+
+header->snapshot_file= -1;
+/*:189*/
+#line 802 "./weaver-memory-manager.tex"
+
+{
+void*mutex= &(header->mutex);
+/*21:*/
+#line 560 "./weaver-memory-manager.tex"
+
+#if defined(__unix__) || defined(__APPLE__)
+if(flags&W_SHARED){
+/*170:*/
+#line 4694 "./weaver-memory-manager.tex"
+
+{
+pthread_mutexattr_t attributes;
+pthread_mutexattr_init(&attributes);
+pthread_mutexattr_setpshared(&attributes,PTHREAD_PROCESS_SHARED);
+#if defined(__linux__)
+pthread_mutexattr_setrobust(&attributes,PTHREAD_MUTEX_ROBUST);
+#endif
+error= pthread_mutex_init((pthread_mutex_t*)mutex,&attributes);
+pthread_mutexattr_destroy(&attributes);
+}
+/*:170*/
+#line 563 "./weaver-memory-manager.tex"
+
+}
+else
+error= pthread_mutex_init((pthread_mutex_t*)mutex,NULL);
+#endif
+#if defined(_WIN32)
+InitializeCriticalSection((CRITICAL_SECTION*)mutex);
+#endif
+/*:21*/
+#line 805 "./weaver-memory-manager.tex"
+
+}
+}
+/*:30*/
+#line 4664 "./weaver-memory-manager.tex"
+
+if(error){
+munmap(arena,M);
+arena= NULL;
+}
+}
+if(arena==NULL&&name!=NULL)
+shm_unlink(name);
+if(arena==NULL||descriptor==NULL)
+close(fd);
+else
+*descriptor= fd;
+if(arena!=NULL){
+/*154:*/
+#line 4451 "./weaver-memory-manager.tex"
+
+#if defined(W_TRACE)
+trace_event(W_TRACE_CREATE,arena,0,t,flags,arena);
+#endif
+/*:154*/
+#line 4677 "./weaver-memory-manager.tex"
+
+}
+return arena;
+#else
+return NULL;
+#endif
+}
+/*:169*//*172:*/
+#line 4733 "./weaver-memory-manager.tex"
+
+void*_Wattach_shared_arena(const char*name,int fd){
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+struct arena_header header;
+void*arena= NULL;
+if(name!=NULL)
+fd= shm_open(name,O_RDWR,0);
+if(fd==-1)
+return NULL;
+if(pread(fd,&header,sizeof(struct arena_header),0)==
+(ssize_t)sizeof(struct arena_header)&&(header.flags&W_SHARED)){
+arena= mmap(header.base,header.total_size,PROT_READ|PROT_WRITE,
+MAP_SHARED|W_MAP_FIXED_NOREPLACE,fd,0);
+if(arena==MAP_FAILED)
+arena= NULL;
+else if(arena!=header.base){
+munmap(arena,header.total_size);
+arena= NULL;
+}
+}
+if(name!=NULL)
+close(fd);
+return arena;
+#else
+return NULL;
+#endif
+}
+/*:172*//*173:*/
+#line 4770 "./weaver-memory-manager.tex"
+
+bool _Wdetach_shared_arena(void*arena){
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+struct arena_header*header= (struct arena_header*)arena;
+if(!(header->flags&W_SHARED))
+return false;
+return(munmap(arena,header->total_size)==0);
+#else
+return false;
+#endif
+}
+/*:173*/
+#line 5557 "./weaver-memory-manager.tex"
 
-if(right)
-allocations= header->right_allocations;
-else
-allocations= header->left_allocations;
-/*33:*/
-#line 879 "./weaver-memory-manager.tex"
+/*182:*/
+#line 4938 "./weaver-memory-manager.tex"
+
+void*_Wopen_file_arena(const char*filename,size_t t,bool private_mapping,
+bool*relocated){
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+bool error= false;
+void*arena= NULL;
+struct stat st;
+int fd,map= (private_mapping)?(MAP_PRIVATE):(MAP_SHARED);
+unsigned flags= W_FILE;
+size_t p,M,header_size= sizeof(struct arena_header);
+/*13:*/
+#line 425 "./weaver-memory-manager.tex"
+
+#if defined(__unix__)
+p= sysconf(_SC_PAGESIZE);
+#endif
+/*:13*//*14:*/
+#line 440 "./weaver-memory-manager.tex"
+
+#if defined(__APPLE__)
+p= getpagesize();
+#endif
+/*:14*//*16:*/
+#line 464 "./weaver-memory-manager.tex"
 
+#if defined(_WIN32)
 {
-int offset;
-struct arena_header*head= (struct arena_header*)arena;
-if(head->remaining_space>=t+((a==0)?(0):(a-1))){
-if(right){
-p= ((char*)head->right_free)-t+1;
-/*32:*/
-#line 839 "./weaver-memory-manager.tex"
+SYSTEM_INFO info;
+GetSystemInfo(&info);
+p= info.dwPageSize;
+}
+#endif
+/*:16*//*18:*/
+#line 496 "./weaver-memory-manager.tex"
 
-offset= 0;
-if(a> 1){
-void*new_p= (void*)(((uintptr_t)p)&(~((uintptr_t)a-1)));
-offset= ((char*)p)-((char*)new_p);
-p= new_p;
+#if defined(__EMSCRIPTEN__)
+p= 64*1024;
+#endif
+/*:18*/
+#line 4948 "./weaver-memory-manager.tex"
+
+if(relocated!=NULL)
+*relocated= false;
+if(private_mapping)
+fd= open(filename,O_RDONLY);
+else
+fd= open(filename,O_RDWR|O_CREAT,S_IRUSR|S_IWUSR);
+if(fd==-1)
+return NULL;
+if(fstat(fd,&st)!=0){
+close(fd);
+return NULL;
 }
-/*:32*/
-#line 886 "./weaver-memory-manager.tex"
+if(st.st_size==0&&!private_mapping){
+M= (((t-1)/p)+1)*p;
+if(M<header_size)
+M= (((header_size-1)/p)+1)*p;
+if(ftruncate(fd,M)==0){
+arena= mmap(NULL,M,PROT_READ|PROT_WRITE,map,fd,0);
+if(arena==MAP_FAILED)
+arena= NULL;
+}
+if(arena!=NULL){
+/*30:*/
+#line 793 "./weaver-memory-manager.tex"
 
-head->right_free= (char*)p-1;
-head->right_allocations+= (t+offset);
+{
+struct arena_header*header= (struct arena_header*)arena;
+header->right_free= ((char*)header)+M-1;
+header->left_free= ((char*)header)+sizeof(struct arena_header);
+header->remaining_space= M-sizeof(struct arena_header);
+header->total_size= M;
+header->left_point= NULL;
+header->right_point= NULL;
+/*46:*/
+#line 1369 "./weaver-memory-manager.tex"
+
+header->left_generation= 0;
+header->right_generation= 0;
+/*:46*//*57:*/
+#line 1607 "./weaver-memory-manager.tex"
+
+header->flags= flags;
+header->page_size= p;
+if(flags&W_GROWABLE){
+header->left_committed= ((char*)arena)+
+(((sizeof(struct arena_header)-1)/p)+1)*p;
+header->right_committed= ((char*)arena)+M-p;
 }
 else{
-p= head->left_free;
-/*30:*/
-#line 810 "./weaver-memory-manager.tex"
+header->left_committed= ((char*)arena)+M;
+header->right_committed= arena;
+}
+/*:57*//*62:*/
+#line 1741 "./weaver-memory-manager.tex"
 
-offset= 0;
-if(a> 1){
-void*new_p= ((char*)p)+(a-1);
-new_p= (void*)(((uintptr_t)new_p)&(~((uintptr_t)a-1)));
-offset= ((char*)new_p)-((char*)p);
-p= new_p;
+header->left_chunk= NULL;
+header->right_chunk= NULL;
+header->chunk_cache= NULL;
+header->cached_chunks= 0;
+/*:62*//*73:*/
+#line 2020 "./weaver-memory-manager.tex"
+
+header->trim_threshold= SIZE_MAX;
+/*:73*//*103:*/
+#line 2898 "./weaver-memory-manager.tex"
+
+header->left_destructors= NULL;
+header->right_destructors= NULL;
+/*:103*//*135:*/
+#line 3805 "./weaver-memory-manager.tex"
+
+header->allocations= 0;
+header->alignment_padding= 0;
+header->left_high_water= 0;
+header->right_high_water= 0;
+header->memory_points= 0;
+header->failed_allocations= 0;
+/*:135*//*141:*/
+#line 3947 "./weaver-memory-manager.tex"
+
+#if defined(W_LOCK_STATS)
+header->lock_acquisitions= 0;
+header->contended_acquisitions= 0;
+header->wait_time= 0;
+header->longest_wait= 0;
+header->longest_wait_operation= -1;
+header->longest_wait_side= -1;
+#endif
+/*:141*//*168:*/
+#line 4618 "./weaver-memory-manager.tex"
+
+header->base= arena;
+/*:168*//*177:*/
+#line 4855 "./weaver-memory-manager.tex"
+
+header->signature= W_SIGNATURE;
+/*:177*//*189:*/
+#line 5155 "./weaver-memory-manager.tex"
+
+header->snapshot_file= -1;
+/*:189*/
+#line 802 "./weaver-memory-manager.tex"
+
+{
+void*mutex= &(header->mutex);
+/*21:*/
+#line 560 "./weaver-memory-manager.tex"
+
+#if defined(__unix__) || defined(__APPLE__)
+if(flags&W_SHARED){
+/*170:*/
+#line 4694 "./weaver-memory-manager.tex"
+
+{
+pthread_mutexattr_t attributes;
+pthread_mutexattr_init(&attributes);
+pthread_mutexattr_setpshared(&attributes,PTHREAD_PROCESS_SHARED);
+#if defined(__linux__)
+pthread_mutexattr_setrobust(&attributes,PTHREAD_MUTEX_ROBUST);
+#endif
+error= pthread_mutex_init((pthread_mutex_t*)mutex,&attributes);
+pthread_mutexattr_destroy(&attributes);
 }
-/*:30*/
-#line 892 "./weaver-memory-manager.tex"
+/*:170*/
+#line 563 "./weaver-memory-manager.tex"
 
-head->left_free= (char*)p+t;
-head->left_allocations+= (t+offset);
 }
-head->remaining_space-= (t+offset);
-#if defined(W_DEBUG_MEMORY)
-if(head->remaining_space<head->smallest_remaining_space)
-head->smallest_remaining_space= head->remaining_space;
+else
+error= pthread_mutex_init((pthread_mutex_t*)mutex,NULL);
+#endif
+#if defined(_WIN32)
+InitializeCriticalSection((CRITICAL_SECTION*)mutex);
 #endif
+/*:21*/
+#line 805 "./weaver-memory-manager.tex"
+
 }
 }
-/*:33*/
-#line 1017 "./weaver-memory-manager.tex"
+/*:30*/
+#line 4971 "./weaver-memory-manager.tex"
 
-point= (struct memory_point*)p;
-if(point!=NULL){
-point->allocations= allocations;
-if(right){
-point->last_memory_point= header->right_point;
-header->right_point= point;
+if(error){
+munmap(arena,M);
+arena= NULL;
+}
 }
+if(arena==NULL)
+error= (ftruncate(fd,0)!=0);
 else{
-point->last_memory_point= header->left_point;
-header->left_point= point;
+/*154:*/
+#line 4451 "./weaver-memory-manager.tex"
+
+#if defined(W_TRACE)
+trace_event(W_TRACE_CREATE,arena,0,t,flags,arena);
+#endif
+/*:154*/
+#line 4980 "./weaver-memory-manager.tex"
+
+}
+}
+else if(st.st_size> 0){
+struct arena_header header;
+if(pread(fd,&header,header_size,0)==(ssize_t)header_size&&
+/*179:*/
+#line 4872 "./weaver-memory-manager.tex"
+
+(header.signature==W_SIGNATURE&&
+(header.flags&(W_FILE|W_GROWABLE|W_CHAINED|W_SHARED))==W_FILE&&
+header.total_size==(size_t)st.st_size&&header.total_size%p==0&&
+header.base!=NULL&&((uintptr_t)header.base)%p==0)
+/*:179*/
+#line 4986 "./weaver-memory-manager.tex"
+){
+arena= mmap(header.base,header.total_size,PROT_READ|PROT_WRITE,
+map|W_MAP_FIXED_NOREPLACE,fd,0);
+if(arena==MAP_FAILED&&relocated!=NULL)
+arena= mmap(NULL,header.total_size,PROT_READ|PROT_WRITE,map,
+fd,0);
+if(arena==MAP_FAILED)
+arena= NULL;
+else if(arena!=header.base&&relocated==NULL){
+munmap(arena,header.total_size);
+arena= NULL;
+}
+}
+if(arena!=NULL){
+struct arena_header*header= (struct arena_header*)arena;
+bool moved= (header->base!=arena);
+if((!moved||relocate_arena(header))&&
+/*180:*/
+#line 4887 "./weaver-memory-manager.tex"
+
+((char*)header->left_free>=((char*)arena)+sizeof(struct arena_header)&&
+(char*)header->right_free<((char*)arena)+header->total_size&&
+((char*)header->right_free)+1>=(char*)header->left_free&&
+header->remaining_space==
+(size_t)(((char*)header->right_free)+1-(char*)header->left_free)&&
+(header->left_point==NULL||
+(header->left_point> arena&&header->left_point<header->left_free))&&
+(header->right_point==NULL||
+(header->right_point> header->right_free&&
+header->right_point<(void*)(((char*)arena)+header->total_size))))
+/*:180*/
+#line 5003 "./weaver-memory-manager.tex"
+){
+/*181:*/
+#line 4911 "./weaver-memory-manager.tex"
+
+#if defined(W_LOCK_STATS)
+header->lock_acquisitions= 0;
+header->contended_acquisitions= 0;
+header->wait_time= 0;
+header->longest_wait= 0;
+header->longest_wait_operation= -1;
+header->longest_wait_side= -1;
+#endif
+{
+void*mutex= &(header->mutex);
+/*21:*/
+#line 560 "./weaver-memory-manager.tex"
+
+#if defined(__unix__) || defined(__APPLE__)
+if(flags&W_SHARED){
+/*170:*/
+#line 4694 "./weaver-memory-manager.tex"
+
+{
+pthread_mutexattr_t attributes;
+pthread_mutexattr_init(&attributes);
+pthread_mutexattr_setpshared(&attributes,PTHREAD_PROCESS_SHARED);
+#if defined(__linux__)
+pthread_mutexattr_setrobust(&attributes,PTHREAD_MUTEX_ROBUST);
+#endif
+error= pthread_mutex_init((pthread_mutex_t*)mutex,&attributes);
+pthread_mutexattr_destroy(&attributes);
+}
+/*:170*/
+#line 563 "./weaver-memory-manager.tex"
+
+}
+else
+error= pthread_mutex_init((pthread_mutex_t*)mutex,NULL);
+#endif
+#if defined(_WIN32)
+InitializeCriticalSection((CRITICAL_SECTION*)mutex);
+#endif
+/*:21*/
+#line 4922 "./weaver-memory-manager.tex"
+
+}
+/*:181*/
+#line 5004 "./weaver-memory-manager.tex"
+
+}
+else
+error= true;
+if(error){
+munmap(arena,header->total_size);
+arena= NULL;
+}
+else if(relocated!=NULL)
+*relocated= moved;
+}
+}
+close(fd);
+return arena;
+#else
+return NULL;
+#endif
 }
+/*:182*//*183:*/
+#line 5034 "./weaver-memory-manager.tex"
+
+bool _Wsync_file_arena(void*arena){
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+struct arena_header*header= (struct arena_header*)arena;
+void*mutex= (void*)&(header->mutex);
+bool ret;
+if(!(header->flags&W_FILE))
+return false;
+/*142:*/
+#line 3966 "./weaver-memory-manager.tex"
+
+#if defined(W_LOCK_STATS)
+lock_mutex(mutex,__func__,-1);
+#else
+/*23:*/
+#line 591 "./weaver-memory-manager.tex"
+
+#if defined(W_LOCK_STATS)
+lock_mutex(mutex,__func__,right);
+#else
+#if defined(__unix__) || defined(__APPLE__)
+if(pthread_mutex_lock((pthread_mutex_t*)mutex)==EOWNERDEAD){
+/*171:*/
+#line 4716 "./weaver-memory-manager.tex"
+
+#if defined(__linux__)
+pthread_mutex_consistent((pthread_mutex_t*)mutex);
+#endif
+/*:171*/
+#line 597 "./weaver-memory-manager.tex"
+
 }
+#endif
+#if defined(_WIN32)
+EnterCriticalSection((CRITICAL_SECTION*)mutex);
+#endif
+#endif
+/*:23*/
+#line 3970 "./weaver-memory-manager.tex"
+
+#endif
+/*:142*/
+#line 5042 "./weaver-memory-manager.tex"
+
+ret= (msync(arena,header->total_size,MS_SYNC)==0);
 /*24:*/
-#line 596 "./weaver-memory-manager.tex"
+#line 611 "./weaver-memory-manager.tex"
 
 #if defined(__unix__) || defined(__APPLE__)
 pthread_mutex_unlock((pthread_mutex_t*)mutex);
@@ -430,79 +4547,166 @@ pthread_mutex_unlock((pthread_mutex_t*)mutex);
 LeaveCriticalSection((CRITICAL_SECTION*)mutex);
 #endif
 /*:24*/
-#line 1030 "./weaver-memory-manager.tex"
+#line 5044 "./weaver-memory-manager.tex"
 
-if(point==NULL)
+return ret;
+#else
 return false;
-return true;
+#endif
 }
-/*:37*/
-#line 1098 "./weaver-memory-manager.tex"
+/*:183*//*184:*/
+#line 5060 "./weaver-memory-manager.tex"
 
-/*38:*/
-#line 1047 "./weaver-memory-manager.tex"
+bool _Wclose_file_arena(void*arena){
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+struct arena_header*header= (struct arena_header*)arena;
+void*mutex= (void*)&(header->mutex);
+size_t M= header->total_size;
+bool ret;
+if(!(header->flags&W_FILE))
+return false;
+ret= (msync(arena,M,MS_SYNC)==0);
+/*22:*/
+#line 578 "./weaver-memory-manager.tex"
 
-void _Wtrash(void*arena,int right){
-struct arena_header*head= (struct arena_header*)arena;
-void*mutex= (void*)&(head->mutex);
-struct memory_point*point;
+#if defined(__unix__) || defined(__APPLE__)
+pthread_mutex_destroy((pthread_mutex_t*)mutex);
+#endif
+#if defined(_WIN32)
+DeleteCriticalSection((CRITICAL_SECTION*)mutex);
+#endif
+/*:22*/
+#line 5070 "./weaver-memory-manager.tex"
+
+return(munmap(arena,M)==0)&&ret;
+#else
+return false;
+#endif
+}
+/*:184*/
+#line 5558 "./weaver-memory-manager.tex"
+
+/*194:*/
+#line 5267 "./weaver-memory-manager.tex"
+
+bool _Wsnapshot(void*arena){
+#if defined(__linux__)
+struct arena_header*header= (struct arena_header*)arena;
+void*mutex= (void*)&(header->mutex);
+bool ret;
+if(!(header->flags&W_SNAPSHOT))
+return false;
+/*142:*/
+#line 3966 "./weaver-memory-manager.tex"
+
+#if defined(W_LOCK_STATS)
+lock_mutex(mutex,__func__,-1);
+#else
 /*23:*/
-#line 582 "./weaver-memory-manager.tex"
+#line 591 "./weaver-memory-manager.tex"
 
+#if defined(W_LOCK_STATS)
+lock_mutex(mutex,__func__,right);
+#else
 #if defined(__unix__) || defined(__APPLE__)
-pthread_mutex_lock((pthread_mutex_t*)mutex);
+if(pthread_mutex_lock((pthread_mutex_t*)mutex)==EOWNERDEAD){
+/*171:*/
+#line 4716 "./weaver-memory-manager.tex"
+
+#if defined(__linux__)
+pthread_mutex_consistent((pthread_mutex_t*)mutex);
+#endif
+/*:171*/
+#line 597 "./weaver-memory-manager.tex"
+
+}
 #endif
 #if defined(_WIN32)
 EnterCriticalSection((CRITICAL_SECTION*)mutex);
 #endif
+#endif
 /*:23*/
-#line 1052 "./weaver-memory-manager.tex"
+#line 3970 "./weaver-memory-manager.tex"
 
-if(right){
-point= head->right_point;
-}
-else{
-point= head->left_point;
-}
-if(point==NULL){
-/*35:*/
-#line 951 "./weaver-memory-manager.tex"
+#endif
+/*:142*/
+#line 5275 "./weaver-memory-manager.tex"
 
-{
-struct arena_header*header= arena;
-if(right){
-header->right_free= ((char*)arena)+header->total_size-1;
-header->remaining_space+= header->right_allocations;
-header->right_allocations= 0;
-}
-else{
-header->left_free= ((char*)arena)+sizeof(struct arena_header);
-header->remaining_space+= header->left_allocations;
-header->left_allocations= 0;
-}
-}
-/*:35*/
-#line 1060 "./weaver-memory-manager.tex"
+ret= discard_private_pages(header,true);
+/*24:*/
+#line 611 "./weaver-memory-manager.tex"
 
+#if defined(__unix__) || defined(__APPLE__)
+pthread_mutex_unlock((pthread_mutex_t*)mutex);
+#endif
+#if defined(_WIN32)
+LeaveCriticalSection((CRITICAL_SECTION*)mutex);
+#endif
+/*:24*/
+#line 5277 "./weaver-memory-manager.tex"
+
+return ret;
+#else
+return false;
+#endif
 }
-else{
-if(right){
-head->remaining_space+= (head->right_allocations-
-point->allocations);
-head->right_point= point->last_memory_point;
-head->right_allocations= point->allocations;
-head->right_free= ((char*)point)+sizeof(struct memory_point)-1;
-}
-else{
-head->remaining_space+= (head->left_allocations-
-point->allocations);
-head->left_point= point->last_memory_point;
-head->left_allocations= point->allocations;
-head->left_free= point;
-}
+/*:194*//*195:*/
+#line 5301 "./weaver-memory-manager.tex"
+
+bool _Wrestore(void*arena){
+#if defined(__linux__)
+struct arena_header*header= (struct arena_header*)arena;
+void*mutex= (void*)&(header->mutex);
+char saved_mutex[sizeof(header->mutex)];
+size_t left_generation,right_generation;
+bool ret;
+if(!(header->flags&W_SNAPSHOT))
+return false;
+/*142:*/
+#line 3966 "./weaver-memory-manager.tex"
+
+#if defined(W_LOCK_STATS)
+lock_mutex(mutex,__func__,-1);
+#else
+/*23:*/
+#line 591 "./weaver-memory-manager.tex"
+
+#if defined(W_LOCK_STATS)
+lock_mutex(mutex,__func__,right);
+#else
+#if defined(__unix__) || defined(__APPLE__)
+if(pthread_mutex_lock((pthread_mutex_t*)mutex)==EOWNERDEAD){
+/*171:*/
+#line 4716 "./weaver-memory-manager.tex"
+
+#if defined(__linux__)
+pthread_mutex_consistent((pthread_mutex_t*)mutex);
+#endif
+/*:171*/
+#line 597 "./weaver-memory-manager.tex"
+
 }
+#endif
+#if defined(_WIN32)
+EnterCriticalSection((CRITICAL_SECTION*)mutex);
+#endif
+#endif
+/*:23*/
+#line 3970 "./weaver-memory-manager.tex"
+
+#endif
+/*:142*/
+#line 5311 "./weaver-memory-manager.tex"
+
+memcpy(saved_mutex,mutex,sizeof(header->mutex));
+left_generation= header->left_generation;
+right_generation= header->right_generation;
+ret= discard_private_pages(header,false);
+memcpy(mutex,saved_mutex,sizeof(header->mutex));
+header->left_generation= left_generation+1;
+header->right_generation= right_generation+1;
 /*24:*/
-#line 596 "./weaver-memory-manager.tex"
+#line 611 "./weaver-memory-manager.tex"
 
 #if defined(__unix__) || defined(__APPLE__)
 pthread_mutex_unlock((pthread_mutex_t*)mutex);
@@ -511,10 +4715,14 @@ pthread_mutex_unlock((pthread_mutex_t*)mutex);
 LeaveCriticalSection((CRITICAL_SECTION*)mutex);
 #endif
 /*:24*/
-#line 1078 "./weaver-memory-manager.tex"
+#line 5319 "./weaver-memory-manager.tex"
 
+return ret;
+#else
+return false;
+#endif
 }
-/*:38*/
-#line 1099 "./weaver-memory-manager.tex"
+/*:195*/
+#line 5559 "./weaver-memory-manager.tex"
 
-/*:39*/
+/*:201*/
@@ -28,7 +28,257 @@ bool _Wmempoint(void*arena,unsigned alignment,int regiao);
 #line 274 "./weaver-memory-manager.tex"
 
 void _Wtrash(void*arena,int regiao);
-/*:6*/
+/*:6*//*44:*/
+#line 1324 "./weaver-memory-manager.tex"
+
+struct _Wbuffer{
+void*arena;
+char*free,*end;
+size_t size,generation;
+int right;
+};
+void _Winit_buffer(struct _Wbuffer*buffer,void*arena,int right,
+size_t size);
+void*_Walloc_buffer(struct _Wbuffer*buffer,unsigned alignment,
+size_t size);
+/*:44*//*51:*/
+#line 1489 "./weaver-memory-manager.tex"
+
+#define W_GROWABLE 1
+void*_Wcreate_arena_flags(size_t size,unsigned flags);
+/*:51*//*59:*/
+#line 1694 "./weaver-memory-manager.tex"
+
+#define W_CHAINED 2
+/*:59*//*74:*/
+#line 2030 "./weaver-memory-manager.tex"
+
+void _Wset_trim_threshold(void*arena,size_t threshold);
+/*:74*//*77:*/
+#line 2087 "./weaver-memory-manager.tex"
+
+void _Wtrim(void*arena);
+/*:77*//*79:*/
+#line 2129 "./weaver-memory-manager.tex"
+
+#define W_HUGE_PAGES 4
+/*:79*//*82:*/
+#line 2232 "./weaver-memory-manager.tex"
+
+size_t _Wpage_size(void*arena);
+/*:82*//*84:*/
+#line 2271 "./weaver-memory-manager.tex"
+
+#define W_PREFAULT 8
+#define W_LOCKED 16
+/*:84*//*90:*/
+#line 2464 "./weaver-memory-manager.tex"
+
+bool _Walloc_batch(void*arena,int right,size_t count,
+const size_t*sizes,const unsigned*alignments,
+void**out);
+/*:90*//*94:*/
+#line 2625 "./weaver-memory-manager.tex"
+
+#include <stdint.h>  
+struct _Warena_fields{
+/*28:*/
+#line 761 "./weaver-memory-manager.tex"
+
+void*left_free,*right_free;
+size_t remaining_space;
+/*:28*//*55:*/
+#line 1592 "./weaver-memory-manager.tex"
+
+unsigned flags;
+/*:55*//*133:*/
+#line 3786 "./weaver-memory-manager.tex"
+
+size_t allocations,alignment_padding;
+/*:133*/
+#line 2628 "./weaver-memory-manager.tex"
+
+};
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(W_TRACE)
+static inline void*_Walloc_inline(void*arena,unsigned a,int right,
+size_t t){
+struct _Warena_fields*header= (struct _Warena_fields*)arena;
+char*old_free,*p,*new_free;
+void**free_pointer;
+size_t r,total;
+if(header->flags&(W_GROWABLE|W_CHAINED))
+return _Walloc(arena,a,right,t);
+r= __atomic_load_n(&(header->remaining_space),__ATOMIC_ACQUIRE);
+if(r<t)
+return _Walloc(arena,a,right,t);
+free_pointer= (right)?(&(header->right_free)):(&(header->left_free));
+old_free= (char*)__atomic_load_n(free_pointer,__ATOMIC_ACQUIRE);
+if(right){
+p= old_free-t+1;
+if(a> 1)
+p= (char*)(((uintptr_t)p)&(~((uintptr_t)a-1)));
+new_free= p-1;
+total= old_free-new_free;
+}
+else{
+p= old_free;
+if(a> 1)
+p= (char*)((((uintptr_t)p)+(a-1))&(~((uintptr_t)a-1)));
+new_free= p+t;
+total= new_free-old_free;
+}
+if(r<total)
+return _Walloc(arena,a,right,t);
+if(!__atomic_compare_exchange_n(&(header->remaining_space),&r,
+r-total,false,__ATOMIC_ACQ_REL,
+__ATOMIC_ACQUIRE))
+return _Walloc(arena,a,right,t);
+if(!__atomic_compare_exchange_n(free_pointer,(void**)&old_free,
+(void*)new_free,false,
+__ATOMIC_ACQ_REL,__ATOMIC_ACQUIRE)){
+__atomic_fetch_add(&(header->remaining_space),total,
+__ATOMIC_ACQ_REL);
+return _Walloc(arena,a,right,t);
+}
+__atomic_fetch_add(&(header->allocations),1,__ATOMIC_RELAXED);
+if(total!=t)
+__atomic_fetch_add(&(header->alignment_padding),total-t,
+__ATOMIC_RELAXED);
+return p;
+}
+#else
+#define _Walloc_inline(arena, a, right, t) _Walloc(arena, a, right, t)
+#endif
+/*:94*//*99:*/
+#line 2861 "./weaver-memory-manager.tex"
+
+bool _Wregister_destructor(void*arena,int right,
+void(*destructor)(void*),void*object);
+/*:99*//*109:*/
+#line 3079 "./weaver-memory-manager.tex"
+
+#define W_MAX_FRAMES 8
+struct _Wframe_ring{
+void*arena[W_MAX_FRAMES];
+unsigned number_of_frames;
+size_t frame;
+};
+bool _Wcreate_frame_ring(struct _Wframe_ring*ring,unsigned n,
+size_t size,unsigned flags);
+bool _Wdestroy_frame_ring(struct _Wframe_ring*ring);
+void*_Wbegin_frame(struct _Wframe_ring*ring);
+void*_Wframe_arena(struct _Wframe_ring*ring);
+/*:109*//*115:*/
+#line 3210 "./weaver-memory-manager.tex"
+
+void*_Wcreate_pool(void*arena,int right,unsigned alignment,
+unsigned number_of_classes,const size_t*sizes,
+const size_t*counts);
+void*_Wpool_alloc(void*pool,size_t size);
+void _Wpool_free(void*pool,void*p);
+void _Wpool_free_remote(void*pool,void*p);
+/*:115*//*121:*/
+#line 3396 "./weaver-memory-manager.tex"
+
+void*_Wrealloc(void*arena,unsigned a,int right,void*p,
+size_t old_size,size_t new_size);
+bool _Wpop(void*arena,int right,void*p,size_t size);
+/*:121*//*126:*/
+#line 3570 "./weaver-memory-manager.tex"
+
+struct _Wmark{
+void*free,*memory_point,*destructors;
+int right;
+};
+void _Wset_mark(void*arena,int right,struct _Wmark*mark);
+bool _Wtrash_to(void*arena,struct _Wmark*mark);
+bool _Wcommit(void*arena,int right);
+/*:126*//*132:*/
+#line 3760 "./weaver-memory-manager.tex"
+
+struct _Wstats{
+size_t total_size,remaining_space;
+size_t left_used,right_used;
+size_t left_high_water,right_high_water;
+size_t allocations,memory_points;
+size_t alignment_padding,failed_allocations;
+};
+void _Wget_stats(void*arena,struct _Wstats*stats);
+/*:132*//*139:*/
+#line 3921 "./weaver-memory-manager.tex"
+
+struct _Wlock_stats{
+size_t acquisitions,contended_acquisitions;
+unsigned long long wait_time,longest_wait;
+const char*longest_wait_operation;
+int longest_wait_side;
+};
+bool _Wget_lock_stats(void*arena,struct _Wlock_stats*stats);
+/*:139*//*148:*/
+#line 4141 "./weaver-memory-manager.tex"
+
+#define W_TRACE_CREATE   0
+#define W_TRACE_ALLOC    1
+#define W_TRACE_MEMPOINT 2
+#define W_TRACE_TRASH    3
+#define W_TRACE_DESTROY  4
+#define W_TRACE_MARK     5
+#define W_TRACE_TRASH_TO 6
+#define W_TRACE_COMMIT   7
+#define W_TRACE_POP      8
+#define W_TRACE_REALLOC  9
+#define W_TRACE_BATCH    10
+struct _Wtrace_event{
+uint64_t time,arena,size,offset,previous_size;
+uint32_t thread,sequence,alignment;
+uint8_t type,right;
+};
+bool _Wbegin_trace(const char*filename);
+void _Wflush_trace(void);
+bool _Wend_trace(void);
+/*:148*//*166:*/
+#line 4588 "./weaver-memory-manager.tex"
+
+#define W_SHARED 32
+void*_Wcreate_shared_arena(const char*name,size_t size,int*fd);
+void*_Wattach_shared_arena(const char*name,int fd);
+bool _Wdetach_shared_arena(void*arena);
+/*:166*//*175:*/
+#line 4818 "./weaver-memory-manager.tex"
+
+#define W_FILE 64
+void*_Wopen_file_arena(const char*filename,size_t size,bool private_mapping,
+bool*relocated);
+bool _Wsync_file_arena(void*arena);
+bool _Wclose_file_arena(void*arena);
+/*:175*//*185:*/
+#line 5090 "./weaver-memory-manager.tex"
+
+#define W_SNAPSHOT 128
+bool _Wsnapshot(void*arena);
+bool _Wrestore(void*arena);
+/*:185*//*196:*/
+#line 5348 "./weaver-memory-manager.tex"
+
+typedef uint32_t _Wrelptr;
+static inline _Wrelptr _Wrelative(void*arena,void*p){
+if(p==NULL)
+return 0;
+#if !defined(NDEBUG)
+if((uintptr_t)p<=(uintptr_t)arena||
+(uintptr_t)p-(uintptr_t)arena> UINT32_MAX)
+abort();
+#endif
+return(_Wrelptr)(((char*)p)-(char*)arena);
+}
+static inline void*_Wabsolute(void*arena,_Wrelptr offset){
+return(offset==0)?(NULL):((void*)(((char*)arena)+offset));
+}
+/*:196*//*197:*/
+#line 5372 "./weaver-memory-manager.tex"
+
+void*_Wcreate_arena_at(void*address,size_t size,unsigned flags);
+/*:197*/
 #line 182 "./weaver-memory-manager.tex"
 
 #ifdef __cplusplus
@@ -0,0 +1,141 @@
+/*95:*/
+#line 2722 "./weaver-memory-manager.tex"
+
+#ifndef WEAVER_MEMORY_MANAGER_HPP
+#define WEAVER_MEMORY_MANAGER_HPP
+#include <cstddef> 
+#include <new> 
+#include <type_traits> 
+#include <utility> 
+#include "memory.h"
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<memory_resource> )
+#include <memory_resource> 
+#define W_MEMORY_RESOURCE
+#endif
+#endif
+/*96:*/
+#line 2756 "./weaver-memory-manager.tex"
+
+template<typename T> class Wallocator{
+public:
+typedef T value_type;
+void*arena;
+int right;
+Wallocator(void*arena,int right)noexcept:arena(arena),right(right){
+}
+template<typename U> Wallocator(const Wallocator<U> &other)noexcept:
+arena(other.arena),right(other.right){
+}
+T*allocate(std::size_t n){
+void*p;
+if(n> ((std::size_t)-1)/sizeof(T))
+throw std::bad_alloc();
+p= _Walloc(arena,alignof(T),right,n*sizeof(T));
+if(p==NULL)
+throw std::bad_alloc();
+return static_cast<T*> (p);
+}
+void deallocate(T*p,std::size_t n)noexcept{
+}
+};
+template<typename T,typename U> 
+bool operator==(const Wallocator<T> &a,const Wallocator<U> &b)noexcept{
+return a.arena==b.arena&&a.right==b.right;
+}
+template<typename T,typename U> 
+bool operator!=(const Wallocator<T> &a,const Wallocator<U> &b)noexcept{
+return!(a==b);
+}
+/*:96*/
+#line 2736 "./weaver-memory-manager.tex"
+
+/*97:*/
+#line 2797 "./weaver-memory-manager.tex"
+
+class Wmempoint_guard{
+public:
+Wmempoint_guard(void*arena,int right,unsigned alignment= 0):
+arena(arena),right(right){
+if(!_Wmempoint(arena,alignment,right))
+throw std::bad_alloc();
+}
+~Wmempoint_guard(){
+_Wtrash(arena,right);
+}
+Wmempoint_guard(const Wmempoint_guard&)= delete;
+Wmempoint_guard&operator= (const Wmempoint_guard&)= delete;
+private:
+void*arena;
+int right;
+};
+/*:97*/
+#line 2737 "./weaver-memory-manager.tex"
+
+/*108:*/
+#line 3017 "./weaver-memory-manager.tex"
+
+template<typename T> void Wdestroy(void*object){
+static_cast<T*> (object)->~T();
+}
+template<typename T,bool trivial= std::is_trivially_destructible<T> ::value> 
+struct Wdestructor{
+static bool register_destructor(void*arena,int right,T*object){
+return _Wregister_destructor(arena,right,Wdestroy<T> ,object);
+}
+};
+template<typename T> struct Wdestructor<T,true> {
+static bool register_destructor(void*arena,int right,T*object){
+return true;
+}
+};
+template<typename T,typename...Args> 
+T*Wnew(void*arena,int right,Args&&...args){
+T*object;
+void*p= _Walloc(arena,alignof(T),right,sizeof(T));
+if(p==NULL)
+throw std::bad_alloc();
+object= new(p)T(std::forward<Args> (args)...);
+
+if(!Wdestructor<T> ::register_destructor(arena,right,object)){
+object->~T();
+throw std::bad_alloc();
+}
+return object;
+}
+/*:108*/
+#line 2738 "./weaver-memory-manager.tex"
+
+#if defined(W_MEMORY_RESOURCE)
+/*98:*/
+#line 2823 "./weaver-memory-manager.tex"
+
+class Wmemory_resource:public std::pmr::memory_resource{
+public:
+void*arena;
+int right;
+Wmemory_resource(void*arena,int right)noexcept:
+arena(arena),right(right){
+}
+protected:
+void*do_allocate(std::size_t bytes,std::size_t alignment)override{
+void*p= _Walloc(arena,(unsigned)alignment,right,bytes);
+if(p==NULL)
+throw std::bad_alloc();
+return p;
+}
+void do_deallocate(void*p,std::size_t bytes,
+std::size_t alignment)override{
+}
+bool do_is_equal(const std::pmr::memory_resource&other)const noexcept
+override{
+const Wmemory_resource*r= dynamic_cast<const Wmemory_resource*> (&other);
+return r!=NULL&&r->arena==arena&&r->right==right;
+}
+};
+/*:98*/
+#line 2740 "./weaver-memory-manager.tex"
+
+#endif
+#endif
+/*:95*/
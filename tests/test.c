@@ -12,6 +12,10 @@
 #endif
 #if defined(__unix__) || defined(__APPLE__)
 #include <pthread.h>
+#include <sys/mman.h> // Include 'mincore'
+#endif
+#if defined(__linux__)
+#include <sys/wait.h> // Include 'waitpid'
 #endif
 
 #include "../src/memory.h"
@@ -86,18 +90,37 @@ static void set_page_size(void){
 
 /* Início dos Testes */
 struct arena_header{
+  void *left_free, *right_free;
+  size_t remaining_space;
+  unsigned flags;
+  size_t allocations, alignment_padding;
   #if defined(__unix__) || defined(__APPLE__)
   pthread_mutex_t mutex;
 #endif
 #if defined(_WIN32)
   CRITICAL_SECTION mutex;
 #endif
-  void *left_free, *right_free;
   void *left_point, *right_point;
-  size_t remaining_space, total_size, right_allocations, left_allocations;
-#if defined(W_DEBUG_MEMORY)
-  size_t smallest_remaining_space;
+  size_t total_size;
+  char padding1[64];
+  size_t left_generation, right_generation;
+  char padding2[64];
+  size_t page_size;
+  void *left_committed, *right_committed;
+  void *left_chunk, *right_chunk, *chunk_cache;
+  size_t cached_chunks;
+  size_t trim_threshold;
+  struct destructor *left_destructors, *right_destructors;
+  size_t left_high_water, right_high_water;
+  size_t memory_points, failed_allocations;
+#if defined(W_LOCK_STATS)
+  size_t lock_acquisitions, contended_acquisitions;
+  unsigned long long wait_time, longest_wait;
+  int longest_wait_operation, longest_wait_side;
 #endif
+  void *base;
+  size_t signature;
+  int snapshot_file;
 };
 
 void test_Wcreate_arena(void){
@@ -235,8 +258,9 @@ void test_allocation(void){
 }
 
 struct memory_point{
-  size_t allocations; // Left or right
+  void *free; // Left or right
   struct memory_point *last_memory_point;
+  struct destructor *destructors;
 };
 
 void test_memorypoint(void){
@@ -282,8 +306,10 @@ void test_memorypoint2(void){
 	 p3 != NULL && p4 != NULL);
   assert("Memory is cleaned after trash function",
 	 header -> remaining_space == space &&
-	 header -> left_allocations == 0 &&
-	 header -> right_allocations == 0 &&
+	 header -> left_free == (void *)
+	 ((char *) arena + sizeof(struct arena_header)) &&
+	 header -> right_free == (void *)
+	 ((char *) arena + header -> total_size - 1) &&
 	 header -> right_point == NULL &&
 	 header -> left_point == NULL);
   _Wdestroy_arena(arena);
@@ -409,6 +435,85 @@ void test_threads(void){
   
 }
 
+#define LOCK_FREE_THREADS 16
+#define LOCK_FREE_ALLOCATIONS 1000
+
+struct lock_free_argument{
+  void *arena;
+  int id;
+  bool ok;
+};
+
+#if defined(_WIN32)
+DWORD _WINAPI lock_free_function(void *arg){
+#else
+void *lock_free_function(void *arg){
+#endif
+  struct lock_free_argument *argument = (struct lock_free_argument *) arg;
+  int i, j, id = argument -> id;
+  char *p[LOCK_FREE_ALLOCATIONS];
+  argument -> ok = true;
+  for(i = 0; i < LOCK_FREE_ALLOCATIONS; i ++){
+    p[i] = (char *) _Walloc(argument -> arena, 8, id % 2, 24);
+    if(p[i] == NULL || ((long long) p[i]) % 8 != 0)
+      argument -> ok = false;
+    else
+      for(j = 0; j < 24; j ++)
+	p[i][j] = (char) id;
+  }
+  for(i = 0; i < LOCK_FREE_ALLOCATIONS; i ++)
+    if(p[i] != NULL)
+      for(j = 0; j < 24; j ++)
+	if(p[i][j] != (char) id)
+	  argument -> ok = false;
+#if defined(_WIN32)
+  return 0;
+#else
+  return NULL;
+#endif
+}
+
+void test_lock_free_threads(void){
+#if defined(_WIN32)
+  HANDLE thread[LOCK_FREE_THREADS];
+#else
+  pthread_t thread[LOCK_FREE_THREADS];
+#endif
+  struct lock_free_argument argument[LOCK_FREE_THREADS];
+  int i;
+  bool ok = true;
+  void *arena = _Wcreate_arena(LOCK_FREE_THREADS * LOCK_FREE_ALLOCATIONS * 32);
+  struct arena_header *header = (struct arena_header *) arena;
+  size_t space = header -> remaining_space;
+  for(i = 0; i < LOCK_FREE_THREADS; i ++){
+    argument[i].arena = arena;
+    argument[i].id = i;
+#if defined(_WIN32)
+    thread[i] = CreateThread(NULL, 0, lock_free_function, &(argument[i]), 0,
+			     NULL);
+#else
+    pthread_create(&(thread[i]), NULL, lock_free_function, &(argument[i]));
+#endif
+  }
+  for(i = 0; i < LOCK_FREE_THREADS; i ++)
+#if defined(_WIN32)
+    _WaitForSingleObject(thread[i], INFINITE);
+#else
+    pthread_join(thread[i], NULL);
+#endif
+  for(i = 0; i < LOCK_FREE_THREADS; i ++)
+    ok = ok && argument[i].ok;
+  ok = ok && (header -> remaining_space ==
+	      (size_t) (((char *) header -> right_free) + 1 -
+			((char *) header -> left_free)));
+  ok = ok && (space - header -> remaining_space ==
+	      LOCK_FREE_THREADS * LOCK_FREE_ALLOCATIONS * 24);
+  _Wtrash(arena, 0);
+  _Wtrash(arena, 1);
+  assert("Concurrent allocations in both stacks don't overlap",
+	 ok && _Wdestroy_arena(arena));
+}
+
 void test_memorypoint5(void){
   void *arena = _Wcreate_arena(10 * page_size);
   void *t1, *t2;
@@ -449,6 +554,1103 @@ void test_memorypoint5(void){
 	 _Wdestroy_arena(arena));
 }
  
+void test_buffer(void){
+  void *arena = _Wcreate_arena(10 * page_size);
+  struct arena_header *header = (struct arena_header *) arena;
+  size_t space = header -> remaining_space;
+  struct _Wbuffer left, right;
+  char *p1, *p2, *p3, *p4, *big;
+  char *start = (char *) arena + sizeof(struct arena_header);
+  bool ok = true;
+  _Winit_buffer(&left, arena, 0, 1024);
+  _Winit_buffer(&right, arena, 1, 1024);
+  p1 = (char *) _Walloc_buffer(&left, 0, 10);
+  p2 = (char *) _Walloc_buffer(&left, 8, 10);
+  if(p1 != start || ((long long) p2) % 8 != 0 || p2 < p1 + 10 ||
+     p2 >= p1 + 18)
+    ok = false;
+  p3 = (char *) _Walloc_buffer(&right, 0, 10);
+  if(p3 != (char *) arena + header -> total_size - 1024)
+    ok = false;
+  // Only one block was taken from each stack
+  if(header -> remaining_space != space - 2048)
+    ok = false;
+  // Big allocations go directly to the arena, keeping the block
+  big = (char *) _Walloc_buffer(&left, 0, 2048);
+  p4 = (char *) _Walloc_buffer(&left, 0, 10);
+  if(big != start + 1024 || p4 != p2 + 10 ||
+     header -> remaining_space != space - 4096)
+    ok = false;
+  // After trash, blocks are discarded and taken again
+  _Wtrash(arena, 0);
+  _Wtrash(arena, 1);
+  p1 = (char *) _Walloc_buffer(&left, 0, 10);
+  p3 = (char *) _Walloc_buffer(&right, 0, 10);
+  if(p1 != start || p3 != (char *) arena + header -> total_size - 1024 ||
+     header -> remaining_space != space - 2048)
+    ok = false;
+  _Wtrash(arena, 0);
+  _Wtrash(arena, 1);
+  assert("Allocation buffers use blocks from the arena",
+	 ok && _Wdestroy_arena(arena));
+}
+ 
+void test_growable(void){
+  size_t size = 256 * 1024 * 1024;
+  void *arena = _Wcreate_arena_flags(size, W_GROWABLE);
+  struct arena_header *header = (struct arena_header *) arena;
+  size_t space;
+  char *p1, *p2;
+  bool ok = (arena != NULL);
+  if(ok){
+    space = header -> remaining_space;
+    // Nothing beyond the header and the last page is accessible yet
+    if((char *) header -> left_committed - (char *) arena > size / 2 ||
+       (char *) arena + size - (char *) header -> right_committed > size / 2)
+      ok = false;
+    p1 = (char *) _Walloc(arena, 8, 0, 1024 * 1024);
+    p2 = (char *) _Walloc(arena, 8, 1, 1024 * 1024);
+    if(p1 == NULL || p2 == NULL)
+      ok = false;
+    else{
+      memset(p1, 1, 1024 * 1024);
+      memset(p2, 2, 1024 * 1024);
+      if(p1[1024 * 1024 - 1] != 1 || p2[0] != 2 ||
+         (char *) header -> left_committed < p1 + 1024 * 1024 ||
+         (char *) header -> right_committed > p2 ||
+         (char *) header -> left_committed - (char *) arena > size / 2)
+        ok = false;
+    }
+    // The whole reserved space can still be used
+    _Wtrash(arena, 0);
+    _Wtrash(arena, 1);
+    p1 = (char *) _Walloc(arena, 0, 0, space);
+    if(p1 == NULL)
+      ok = false;
+    else
+      p1[space - 1] = 1;
+    if(_Walloc(arena, 0, 1, 1) != NULL)
+      ok = false;
+    _Wtrash(arena, 0);
+    ok = ok && _Wdestroy_arena(arena);
+  }
+  assert("Growable arenas commit memory when stacks grow", ok);
+}
+ 
+void test_chained(void){
+  void *arena = _Wcreate_arena_flags(4 * page_size, W_CHAINED);
+  struct arena_header *header = (struct arena_header *) arena;
+  size_t space = header -> remaining_space;
+  char *p1, *p2, *p3, *p4;
+  void *chunk;
+  bool ok = true;
+  // Filling the arena, the next allocations go to a new chunk
+  p1 = (char *) _Walloc(arena, 0, 0, space - 16);
+  p2 = (char *) _Walloc(arena, 8, 0, 64);
+  chunk = header -> left_chunk;
+  if(p1 == NULL || p2 == NULL || chunk == NULL ||
+     (p2 >= (char *) arena && p2 < (char *) arena + header -> total_size))
+    ok = false;
+  // Even small allocations which fit in the arena go to the chunk now
+  p3 = (char *) _Walloc(arena, 0, 0, 8);
+  if(p3 != p2 + 64 || header -> remaining_space != 16)
+    ok = false;
+  // Memory points inside chunks
+  _Wmempoint(arena, 8, 0);
+  p4 = (char *) _Walloc(arena, 0, 0, 10 * page_size);
+  if(p4 == NULL || header -> left_chunk == chunk)
+    ok = false;
+  _Wtrash(arena, 0);
+  if(header -> left_chunk != chunk || header -> cached_chunks != 1)
+    ok = false;
+  p4 = (char *) _Walloc(arena, 0, 0, 8);
+  if(p4 == NULL || p4 > p3 + 8 + 64)
+    ok = false;
+  _Wtrash(arena, 0);
+  if(header -> left_chunk != NULL || header -> cached_chunks != 2 ||
+     header -> remaining_space != space)
+    ok = false;
+  // Cached chunks are reused by the right stack
+  p1 = (char *) _Walloc(arena, 0, 1, space);
+  p2 = (char *) _Walloc(arena, 0, 1, 64);
+  if(p1 == NULL || p2 == NULL || header -> right_chunk == NULL ||
+     header -> cached_chunks != 1)
+    ok = false;
+  // Chunks in use are reported as leaks
+  ok = ok && !_Wdestroy_arena(arena);
+  assert("Chained arenas use additional chunks when full", ok);
+}
+ 
+#if defined(__linux__)
+size_t resident_pages(void *p, size_t size){
+  unsigned char vec[256];
+  size_t i, count = 0, pages = size / page_size;
+  if(pages > 256)
+    pages = 256;
+  mincore(p, pages * page_size, vec);
+  for(i = 0; i < pages; i ++)
+    if(vec[i] & 1)
+      count ++;
+  return count;
+}
+#endif
+
+void test_trim(void){
+  void *arena = _Wcreate_arena(64 * page_size);
+  struct arena_header *header = (struct arena_header *) arena;
+  char *first_page = (char *) arena + 4 * page_size, *p;
+  bool ok = true;
+  // Without threshold, pages are kept after trash
+  p = (char *) _Walloc(arena, 0, 0, 40 * page_size);
+  memset(p, 1, 40 * page_size);
+  _Wtrash(arena, 0);
+#if defined(__linux__)
+  if(resident_pages(first_page, 32 * page_size) != 32)
+    ok = false;
+#endif
+  // With threshold, only the excess is given back
+  _Wset_trim_threshold(arena, 8 * page_size);
+  p = (char *) _Walloc(arena, 0, 0, 40 * page_size);
+  memset(p, 1, 40 * page_size);
+  _Wtrash(arena, 0);
+#if defined(__linux__)
+  if(resident_pages(first_page, 4 * page_size) != 4 ||
+     resident_pages(first_page + 12 * page_size, 24 * page_size) != 0)
+    ok = false;
+#endif
+  // Memory given back can be used again
+  p = (char *) _Walloc(arena, 0, 1, 40 * page_size);
+  memset(p, 2, 40 * page_size);
+  if(p[0] != 2 || p[40 * page_size - 1] != 2)
+    ok = false;
+  _Wtrash(arena, 1);
+  // Trim gives back everything between the stacks
+  _Wset_trim_threshold(arena, (size_t) -1);
+  _Wtrim(arena);
+#if defined(__linux__)
+  if(resident_pages(first_page, 56 * page_size) != 0)
+    ok = false;
+#endif
+  if(header -> remaining_space + sizeof(struct arena_header) !=
+     header -> total_size)
+    ok = false;
+  assert("Memory is given back to the system after trash and trim",
+	 ok && _Wdestroy_arena(arena));
+}
+ 
+void test_huge_pages(void){
+  void *arena = _Wcreate_arena_flags(3 * 1024 * 1024, W_HUGE_PAGES);
+  struct arena_header *header = (struct arena_header *) arena;
+  size_t size;
+  char *p;
+  bool ok = (arena != NULL);
+  if(ok){
+    size = _Wpage_size(arena);
+    if(size < page_size || size % page_size != 0 ||
+       header -> total_size % size != 0 ||
+       ((long long) arena) % size != 0)
+      ok = false;
+    p = (char *) _Walloc(arena, 0, 0, 3 * 1024 * 1024 - 4096);
+    if(p == NULL)
+      ok = false;
+    else{
+      memset(p, 1, 3 * 1024 * 1024 - 4096);
+      _Wtrash(arena, 0);
+    }
+    ok = ok && _Wdestroy_arena(arena);
+  }
+  arena = _Wcreate_arena(4096);
+  if(arena == NULL || _Wpage_size(arena) != page_size)
+    ok = false;
+  else
+    _Wdestroy_arena(arena);
+  assert("Huge page arenas report the page size used", ok);
+}
+ 
+void test_prefault(void){
+  size_t size = 128 * 1024 * 1024;
+  void *arena = _Wcreate_arena_flags(size, W_PREFAULT);
+  bool ok = (arena != NULL);
+  if(ok){
+#if defined(__linux__)
+    // Pages in the parts touched by each thread are already resident
+    if(resident_pages(arena, 256 * page_size) != 256 ||
+       resident_pages((char *) arena + size / 2, 256 * page_size) != 256 ||
+       resident_pages((char *) arena + size - 256 * page_size,
+                      256 * page_size) != 256)
+      ok = false;
+#endif
+    ok = ok && _Wdestroy_arena(arena);
+  }
+  // Locking can fail because of system limits, but never partially
+  arena = _Wcreate_arena_flags(16 * page_size, W_LOCKED);
+  if(arena != NULL){
+#if defined(__linux__)
+    if(resident_pages(arena, 16 * page_size) != 16)
+      ok = false;
+#endif
+    if(_Walloc(arena, 0, 0, 8 * page_size) == NULL)
+      ok = false;
+    _Wtrash(arena, 0);
+    ok = ok && _Wdestroy_arena(arena);
+  }
+  assert("Prefaulted and locked arenas have resident pages", ok);
+}
+ 
+void test_batch(void){
+  void *arena = _Wcreate_arena(4 * page_size), *out[4];
+  struct arena_header *header = (struct arena_header *) arena;
+  size_t space = header -> remaining_space, total, padding = 0;
+  size_t sizes[4] = {3, 16, 100, 1};
+  unsigned alignments[4] = {0, 16, 8, 64};
+  size_t too_big[2] = {16, 4 * page_size};
+  struct _Wstats stats;
+  int i, right;
+  bool ok = true;
+  for(right = 0; right < 2; right ++){
+    if(!_Walloc_batch(arena, right, 4, sizes, alignments, out))
+      ok = false;
+    for(i = 1; i < 4; i ++)
+      if(((long long) out[i]) % alignments[i] != 0)
+        ok = false;
+    // Allocations don't overlap and are contiguous, except for padding
+    for(i = 0; i < 3; i ++){
+      if(!right && (char *) out[i + 1] < (char *) out[i] + sizes[i])
+        ok = false;
+      if(right && (char *) out[i + 1] + sizes[i + 1] > (char *) out[i])
+        ok = false;
+    }
+    total = (right)?((char *) arena + header -> total_size - (char *) out[3]):
+      ((char *) out[3] + 1 - (char *) arena - sizeof(struct arena_header));
+    if(header -> remaining_space != space - total)
+      ok = false;
+    padding += total - 120;
+    space = header -> remaining_space;
+  }
+  // All or nothing
+  if(_Walloc_batch(arena, 0, 2, too_big, alignments, out) ||
+     out[0] != NULL || out[1] != NULL || header -> remaining_space != space)
+    ok = false;
+  _Wget_stats(arena, &stats);
+  if(stats.allocations != 8 || stats.failed_allocations != 2 ||
+     stats.alignment_padding != padding)
+    ok = false;
+  _Wtrash(arena, 0);
+  _Wtrash(arena, 1);
+  // Batch in chained chunks
+  _Wdestroy_arena(arena);
+  arena = _Wcreate_arena_flags(4 * page_size, W_CHAINED);
+  if(!_Walloc_batch(arena, 1, 2, too_big, alignments, out) ||
+     ((struct arena_header *) arena) -> right_chunk == NULL ||
+     (char *) out[1] < (char *) out[0] + 16)
+    ok = false;
+  _Wget_stats(arena, &stats);
+  if(stats.allocations != 2 || stats.failed_allocations != 0 ||
+     stats.alignment_padding != (size_t) ((char *) out[1] -
+                                          ((char *) out[0] + 16)))
+    ok = false;
+  _Wtrash(arena, 1);
+  assert("Batch allocations are all or nothing", ok && _Wdestroy_arena(arena));
+}
+ 
+void test_inline(void){
+  void *arena = _Wcreate_arena(4 * page_size);
+  struct arena_header *header = (struct arena_header *) arena;
+  size_t space = header -> remaining_space;
+  char *p1, *p2, *p3, *p4;
+  bool ok = true;
+  p1 = (char *) _Walloc_inline(arena, 0, 0, 3);
+  p2 = (char *) _Walloc_inline(arena, 16, 0, 5);
+  p3 = (char *) _Walloc_inline(arena, 0, 1, 3);
+  p4 = (char *) _Walloc_inline(arena, 32, 1, 5);
+  if(p1 != (char *) arena + sizeof(struct arena_header) ||
+     ((long long) p2) % 16 != 0 || p2 < p1 + 3 || p2 >= p1 + 3 + 16 ||
+     p3 != (char *) arena + header -> total_size - 3 ||
+     ((long long) p4) % 32 != 0 || p4 + 5 > p3 || p4 + 5 + 32 <= p3)
+    ok = false;
+  // Same accounting as _Walloc
+  if(header -> remaining_space !=
+     space - (p2 + 5 - p1) - ((char *) arena + header -> total_size - p4))
+    ok = false;
+  if(_Walloc_inline(arena, 0, 0, space) != NULL)
+    ok = false;
+  _Wtrash(arena, 0);
+  _Wtrash(arena, 1);
+  if(header -> remaining_space != space)
+    ok = false;
+  _Wdestroy_arena(arena);
+  // Arenas with options go through _Walloc
+  arena = _Wcreate_arena_flags(4 * page_size, W_CHAINED);
+  if(_Walloc_inline(arena, 8, 0, 8 * page_size) == NULL)
+    ok = false;
+  _Wtrash(arena, 0);
+  assert("Inline allocation works as _Walloc", ok && _Wdestroy_arena(arena));
+}
+
+int destructor_order[8], destructor_count;
+static void record_destructor(void *object){
+  destructor_order[destructor_count ++] = *((int *) object);
+}
+
+static void *reentrant_arena;
+static void reentrant_destructor(void *object){
+  struct _Wstats stats;
+  _Wget_stats(reentrant_arena, &stats);
+  _Wmempoint(reentrant_arena, 0, 0);
+  _Walloc(reentrant_arena, 0, 0, 16);
+  _Wregister_destructor(reentrant_arena, 0, record_destructor, object);
+}
+
+void test_destructors(void){
+  void *arena = _Wcreate_arena(10 * page_size);
+  struct arena_header *header;
+  struct _Wmark mark;
+  size_t initial;
+  int *obj[4], i;
+  bool ok = true;
+  destructor_count = 0;
+  for(i = 0; i < 2; i ++){
+    obj[i] = (int *) _Walloc(arena, 0, 0, sizeof(int));
+    *obj[i] = i;
+    ok = ok && _Wregister_destructor(arena, 0, record_destructor, obj[i]);
+  }
+  _Wmempoint(arena, 0, 0);
+  for(i = 2; i < 4; i ++){
+    obj[i] = (int *) _Walloc(arena, 0, 0, sizeof(int));
+    *obj[i] = i;
+    ok = ok && _Wregister_destructor(arena, 0, record_destructor, obj[i]);
+  }
+  _Wtrash(arena, 1);
+  ok = ok && destructor_count == 0;
+  _Wtrash(arena, 0);
+  ok = ok && destructor_count == 2 && destructor_order[0] == 3 &&
+    destructor_order[1] == 2;
+  _Wtrash(arena, 0);
+  ok = ok && destructor_count == 4 && destructor_order[2] == 1 &&
+    destructor_order[3] == 0;
+  assert("Destructors run in reverse order on _Wtrash", ok);
+  obj[0] = (int *) _Walloc(arena, 0, 1, sizeof(int));
+  *obj[0] = 7;
+  _Wregister_destructor(arena, 1, record_destructor, obj[0]);
+  _Wtrash(arena, 1);
+  assert("Destructors don't leak memory", _Wdestroy_arena(arena) &&
+         destructor_count == 5 && destructor_order[4] == 7);
+  arena = _Wcreate_arena(10 * page_size);
+  obj[0] = (int *) _Walloc(arena, 0, 0, sizeof(int));
+  *obj[0] = 8;
+  _Wregister_destructor(arena, 0, record_destructor, obj[0]);
+  _Wdestroy_arena(arena);
+  assert("Pending destructors run when destroying arena",
+         destructor_count == 6 && destructor_order[5] == 8);
+  arena = reentrant_arena = _Wcreate_arena(10 * page_size);
+  header = (struct arena_header *) arena;
+  initial = header -> remaining_space;
+  destructor_count = 0;
+  obj[0] = (int *) _Walloc(arena, 0, 0, sizeof(int));
+  *obj[0] = 9;
+  _Wregister_destructor(arena, 0, reentrant_destructor, obj[0]);
+  _Wtrash(arena, 0);
+  ok = (destructor_count == 1 && destructor_order[0] == 9 &&
+        header -> left_point == NULL && header -> left_destructors == NULL &&
+        header -> remaining_space == initial);
+  _Wset_mark(arena, 0, &mark);
+  obj[0] = (int *) _Walloc(arena, 0, 0, sizeof(int));
+  *obj[0] = 10;
+  _Wregister_destructor(arena, 0, reentrant_destructor, obj[0]);
+  ok = ok && _Wtrash_to(arena, &mark) && destructor_count == 2 &&
+    destructor_order[1] == 10 && header -> left_point == NULL &&
+    header -> left_destructors == NULL &&
+    header -> remaining_space == initial;
+  assert("Destructors can use their own arena", ok &&
+         _Wdestroy_arena(arena));
+}
+
+void test_frame_ring(void){
+  struct _Wframe_ring ring;
+  void *frame[4], *p[4];
+  int i;
+  bool ok = true;
+  ok = !_Wcreate_frame_ring(&ring, W_MAX_FRAMES + 1, 10 * page_size, 0);
+  ok = ok && _Wcreate_frame_ring(&ring, 3, 10 * page_size, 0);
+  frame[0] = _Wframe_arena(&ring);
+  p[0] = _Walloc(frame[0], 0, 0, 64);
+  memset(p[0], 1, 64);
+  for(i = 1; i < 4; i ++){
+    frame[i] = _Wbegin_frame(&ring);
+    ok = ok && frame[i] == _Wframe_arena(&ring);
+    if(i < 3)
+      ok = ok && *((char *) p[0]) == 1;
+    p[i] = _Walloc(frame[i], 0, 0, 64);
+    memset(p[i], 1, 64);
+    _Wmempoint(frame[i], 0, 0);
+    _Wmempoint(frame[i], 0, 1);
+  }
+  ok = ok && frame[0] != frame[1] && frame[1] != frame[2] &&
+    frame[3] == frame[0] && p[3] == p[0];
+  assert("Frame ring reuses the arena from N frames ago", ok);
+  frame[0] = _Wbegin_frame(&ring);
+  ok = (frame[0] == frame[1] && _Walloc(frame[0], 0, 0, 64) == p[1] &&
+        ((struct arena_header *) frame[0]) -> left_point == NULL &&
+        ((struct arena_header *) frame[0]) -> right_point == NULL);
+  assert("Beginning a frame empties its arena", ok);
+  assert("Destroying a frame ring doesn't leak memory",
+         _Wdestroy_frame_ring(&ring));
+}
+
+void test_pool(void){
+  void *arena = _Wcreate_arena(10 * page_size);
+  size_t sizes[2] = {16, 100}, counts[2] = {4, 2};
+  void *pool, *p[8], *q;
+  int i;
+  bool ok = true;
+  _Wmempoint(arena, 0, 0);
+  ok = (_Wcreate_pool(arena, 0, 0, 2, counts, sizes) == NULL);
+  pool = _Wcreate_pool(arena, 0, 16, 2, sizes, counts);
+  ok = ok && pool != NULL;
+  for(i = 0; i < 6; i ++){
+    p[i] = _Wpool_alloc(pool, 10);
+    ok = ok && p[i] != NULL && ((long long) p[i]) % 16 == 0;
+  }
+  ok = ok && _Wpool_alloc(pool, 10) == NULL && _Wpool_alloc(pool, 200) == NULL;
+  ok = ok && ((char *) p[1]) - ((char *) p[0]) == 16 &&
+    ((char *) p[5]) - ((char *) p[4]) == 112;
+  assert("Pool uses the smallest class with free objects", ok);
+  _Wpool_free(pool, p[2]);
+  _Wpool_free(pool, p[5]);
+  q = _Wpool_alloc(pool, 50);
+  ok = (q == p[5] && _Wpool_alloc(pool, 8) == p[2]);
+  _Wpool_free_remote(pool, p[0]);
+  _Wpool_free_remote(pool, p[1]);
+  q = _Wpool_alloc(pool, 8);
+  ok = ok && (q == p[1] && _Wpool_alloc(pool, 8) == p[0]);
+  assert("Pool reuses objects freed locally and remotely", ok);
+  _Wtrash(arena, 0);
+  assert("Pool is freed with its memory point", _Wdestroy_arena(arena));
+}
+
+void test_realloc(void){
+  void *arena = _Wcreate_arena(10 * page_size);
+  struct arena_header *header = (struct arena_header *) arena;
+  size_t initial = header -> remaining_space;
+  char *p, *q, *other;
+  int i;
+  bool ok = true;
+  // Left stack: in place
+  p = (char *) _Walloc(arena, 8, 0, 100);
+  memset(p, 'a', 100);
+  q = (char *) _Wrealloc(arena, 8, 0, p, 100, 1000);
+  ok = ok && q == p && header -> left_free == p + 1000;
+  q = (char *) _Wrealloc(arena, 8, 0, p, 1000, 50);
+  ok = ok && q == p && header -> left_free == p + 50 && p[49] == 'a';
+  // Right stack: moved inside the arena
+  p = (char *) _Walloc(arena, 8, 1, 100);
+  for(i = 0; i < 100; i ++)
+    p[i] = i;
+  q = (char *) _Wrealloc(arena, 8, 1, p, 100, 1000);
+  ok = ok && q < p && ((long long) q) % 8 == 0 &&
+    header -> right_free == q - 1;
+  for(i = 0; i < 100; i ++)
+    if(q[i] != i)
+      ok = false;
+  p = (char *) _Wrealloc(arena, 8, 1, q, 1000, 10);
+  ok = ok && p > q && header -> right_free == p - 1 && p[9] == 9;
+  assert("Wrealloc grows and shrinks top allocations in place", ok);
+  // Not at the top: copy
+  other = (char *) _Walloc(arena, 0, 1, 1);
+  q = (char *) _Wrealloc(arena, 8, 1, p, 10, 20);
+  ok = (q != p && q < other && q[9] == 9);
+  ok = ok && _Wrealloc(arena, 8, 1, q, 20, 100 * page_size) == NULL;
+  assert("Wrealloc copies allocations not at the top", ok);
+  ok = !_Wpop(arena, 1, p, 10) && _Wpop(arena, 1, q, 20) &&
+    header -> right_free == q + 19;
+  q = (char *) _Walloc(arena, 0, 0, 30);
+  ok = ok && _Wpop(arena, 0, q, 30) && header -> left_free == q;
+  _Wtrash(arena, 0);
+  _Wtrash(arena, 1);
+  assert("Wpop releases only the top allocation",
+         ok && header -> remaining_space == initial &&
+         _Wdestroy_arena(arena));
+}
+
+void test_marks(void){
+  void *arena = _Wcreate_arena(10 * page_size);
+  void *chained = _Wcreate_arena_flags(4 * page_size, W_CHAINED);
+  struct arena_header *header = (struct arena_header *) arena;
+  size_t initial = header -> remaining_space, used;
+  struct _Wmark mark, inner;
+  int obj = 1, i;
+  bool ok;
+  _Walloc(arena, 0, 0, 10);
+  used = header -> remaining_space;
+  _Wset_mark(arena, 0, &mark);
+  ok = (header -> remaining_space == used);
+  for(i = 0; i < 5; i ++){
+    _Wmempoint(arena, 0, 0);
+    _Walloc(arena, 0, 0, 100);
+  }
+  destructor_count = 0;
+  _Wregister_destructor(arena, 0, record_destructor, &obj);
+  _Wtrash_to(arena, &mark);
+  ok = ok && header -> remaining_space == used &&
+    header -> left_point == NULL && destructor_count == 1;
+  assert("Wtrash_to restores many levels at once", ok);
+  _Wmempoint(arena, 0, 1);
+  _Wset_mark(arena, 1, &mark);
+  _Wmempoint(arena, 0, 1);
+  _Walloc(arena, 0, 1, 100);
+  ok = _Wcommit(arena, 1) && header -> right_point != NULL;
+  _Wset_mark(arena, 1, &inner);
+  _Walloc(arena, 0, 1, 100);
+  _Wtrash_to(arena, &inner);
+  _Wtrash_to(arena, &mark);
+  _Wtrash(arena, 1);
+  ok = ok && !_Wcommit(arena, 1) && header -> right_point == NULL;
+  _Wtrash(arena, 0);
+  assert("Wcommit drops a memory point keeping its allocations",
+         ok && header -> remaining_space == initial &&
+         _Wdestroy_arena(arena));
+  _Wset_mark(chained, 0, &mark);
+  _Walloc(chained, 0, 0, 3 * page_size);
+  _Walloc(chained, 0, 0, 3 * page_size);
+  _Wset_mark(chained, 0, &inner);
+  _Walloc(chained, 0, 0, 3 * page_size);
+  _Wtrash_to(chained, &inner);
+  ok = (((struct arena_header *) chained) -> left_chunk != NULL);
+  _Wtrash_to(chained, &mark);
+  ok = ok && ((struct arena_header *) chained) -> left_chunk == NULL;
+  assert("Marks work in chained chunks", ok && _Wdestroy_arena(chained));
+  arena = _Wcreate_arena(10 * page_size);
+  header = (struct arena_header *) arena;
+  _Wmempoint(arena, 0, 0);
+  _Wset_mark(arena, 0, &mark);
+  _Walloc(arena, 0, 0, 100);
+  _Wtrash(arena, 0);
+  used = header -> remaining_space;
+  ok = !_Wtrash_to(arena, &mark) && header -> remaining_space == used &&
+    header -> left_point == NULL;
+  _Walloc(arena, 0, 0, 100);
+  _Wset_mark(arena, 0, &mark);
+  _Wtrash(arena, 0);
+  ok = ok && !_Wtrash_to(arena, &mark) &&
+    header -> remaining_space == used;
+  assert("Wtrash_to refuses stale marks", ok && _Wdestroy_arena(arena));
+}
+
+void test_stats(void){
+  void *arena = _Wcreate_arena(10 * page_size);
+  struct _Wstats stats;
+  char *p;
+  bool ok;
+  _Wget_stats(arena, &stats);
+  ok = (stats.left_used == 0 && stats.right_used == 0 &&
+        stats.allocations == 0 && stats.total_size == 10 * page_size);
+  p = (char *) _Walloc(arena, 0, 0, 1);
+  _Walloc(arena, 8, 0, 16);
+  _Wmempoint(arena, 0, 1);
+  _Walloc_inline(arena, 0, 1, 100);
+  _Walloc(arena, 0, 1, 20 * page_size);
+  _Wget_stats(arena, &stats);
+  ok = ok && stats.allocations == 3 && stats.memory_points == 1 &&
+    stats.failed_allocations == 1 &&
+    stats.alignment_padding == ((8 - ((long long) (p + 1)) % 8) % 8) &&
+    stats.left_used == 17 + stats.alignment_padding &&
+    stats.right_used >= 100 + sizeof(void *) &&
+    stats.left_high_water == stats.left_used &&
+    stats.remaining_space + stats.left_used + stats.right_used +
+    sizeof(struct arena_header) == stats.total_size;
+  assert("Statistics count allocations and padding", ok);
+  _Wtrash(arena, 1);
+  _Wtrash(arena, 0);
+  _Wget_stats(arena, &stats);
+  ok = stats.left_used == 0 && stats.right_used == 0 &&
+    stats.left_high_water == 17 + stats.alignment_padding &&
+    stats.right_high_water >= 100 + sizeof(void *);
+  assert("Statistics keep the high water mark of each stack",
+         ok && _Wdestroy_arena(arena));
+}
+
+#if defined(W_LOCK_STATS) && (defined(__unix__) || defined(__APPLE__))
+static void *contend_mutex(void *arena){
+  _Wmempoint(arena, 0, 1);
+  return NULL;
+}
+#endif
+
+void test_lock_stats(void){
+  void *arena = _Wcreate_arena(10 * page_size);
+  struct _Wlock_stats stats;
+  size_t before;
+  bool ok;
+#if defined(W_LOCK_STATS)
+  ok = _Wget_lock_stats(arena, &stats) && stats.acquisitions == 1 &&
+    stats.contended_acquisitions == 0 && stats.wait_time == 0;
+  before = stats.acquisitions;
+  _Wmempoint(arena, 0, 0);
+  _Wtrash(arena, 0);
+  _Wget_lock_stats(arena, &stats);
+  ok = ok && stats.acquisitions == before + 3 &&
+    stats.contended_acquisitions == 0;
+  {
+    void *chained = _Wcreate_arena_flags(10 * page_size, W_CHAINED);
+    struct _Wstats arena_stats;
+    before = stats.acquisitions;
+    _Wget_stats(arena, &arena_stats);
+    _Wget_lock_stats(arena, &stats);
+    ok = ok && stats.acquisitions == before + 1;
+    _Wget_stats(chained, &arena_stats);
+    _Wget_lock_stats(chained, &stats);
+    ok = ok && stats.acquisitions == 1 && _Wdestroy_arena(chained);
+  }
+#if defined(__unix__) || defined(__APPLE__)
+  {
+    pthread_t thread;
+    struct timespec t = {0, 10000000};
+    pthread_mutex_lock(&(((struct arena_header *) arena) -> mutex));
+    pthread_create(&thread, NULL, contend_mutex, arena);
+    nanosleep(&t, NULL);
+    pthread_mutex_unlock(&(((struct arena_header *) arena) -> mutex));
+    pthread_join(thread, NULL);
+    _Wtrash(arena, 1);
+    _Wget_lock_stats(arena, &stats);
+    ok = ok && stats.contended_acquisitions >= 1 &&
+      stats.longest_wait > 0 && stats.wait_time >= stats.longest_wait &&
+      !strcmp(stats.longest_wait_operation, "_Wmempoint") &&
+      stats.longest_wait_side == 1;
+  }
+#endif
+#else
+  (void) before;
+  ok = !_Wget_lock_stats(arena, &stats) && stats.acquisitions == 0 &&
+    stats.longest_wait_operation == NULL;
+#endif
+  assert("Lock statistics measure mutex contention",
+         ok && _Wdestroy_arena(arena));
+}
+
+#if defined(W_TRACE) && (defined(__unix__) || defined(__APPLE__))
+static void *trace_and_exit(void *arena){
+  int i;
+  for(i = 0; i < 10; i ++)
+    _Walloc(arena, 0, 0, 8);
+  return NULL;
+}
+#endif
+
+void test_trace(void){
+  bool ok;
+#if defined(W_TRACE)
+  const char *filename = "test_trace.bin";
+  struct _Wtrace_event event[10];
+  unsigned types[7] = {W_TRACE_CREATE, W_TRACE_ALLOC, W_TRACE_MEMPOINT,
+                       W_TRACE_ALLOC, W_TRACE_TRASH, W_TRACE_TRASH,
+                       W_TRACE_DESTROY};
+  void *arena, *p;
+  size_t i, n = 0;
+  FILE *file;
+  ok = _Wbegin_trace(filename) && !_Wbegin_trace(filename);
+  arena = _Wcreate_arena(10 * page_size);
+  p = _Walloc(arena, 8, 1, 100);
+  _Wmempoint(arena, 0, 0);
+  _Walloc_inline(arena, 0, 0, 10);
+  _Wtrash(arena, 0);
+  _Wtrash(arena, 1);
+  _Wdestroy_arena(arena);
+  ok = ok && _Wend_trace();
+  file = fopen(filename, "rb");
+  if(file != NULL){
+    n = fread(event, sizeof(struct _Wtrace_event), 8, file);
+    fclose(file);
+  }
+  remove(filename);
+  ok = ok && n == 7 &&
+    event[1].offset == (uint64_t) ((char *) p - (char *) arena) &&
+    event[1].size == 100 && event[1].alignment == 8 && event[1].right == 1 &&
+    event[4].offset == sizeof(struct arena_header) &&
+    event[6].offset == 0 && event[0].size == 10 * page_size;
+  for(i = 0; ok && i < n; i ++)
+    ok = (event[i].arena == (uint64_t) (uintptr_t) arena &&
+          event[i].thread == event[0].thread &&
+          (i == 0 || event[i].time >= event[i - 1].time) &&
+          event[i].type == types[i]);
+  {
+    unsigned more[10] = {W_TRACE_CREATE, W_TRACE_MARK, W_TRACE_ALLOC,
+                         W_TRACE_REALLOC, W_TRACE_POP, W_TRACE_BATCH,
+                         W_TRACE_BATCH, W_TRACE_TRASH_TO, W_TRACE_COMMIT,
+                         W_TRACE_DESTROY};
+    size_t sizes[2] = {8, 24};
+    unsigned alignments[2] = {0, 8};
+    void *out[2];
+    struct _Wmark mark;
+    ok = ok && _Wbegin_trace(filename);
+    arena = _Wcreate_arena(10 * page_size);
+    _Wset_mark(arena, 0, &mark);
+    p = _Walloc(arena, 0, 0, 16);
+    _Wrealloc(arena, 0, 0, p, 16, 32);
+    _Wpop(arena, 0, p, 32);
+    _Walloc_batch(arena, 0, 2, sizes, alignments, out);
+    _Wtrash_to(arena, &mark);
+    _Wcommit(arena, 0);
+    _Wdestroy_arena(arena);
+    ok = ok && _Wend_trace();
+    n = 0;
+    file = fopen(filename, "rb");
+    if(file != NULL){
+      n = fread(event, sizeof(struct _Wtrace_event), 10, file);
+      fclose(file);
+    }
+    remove(filename);
+    ok = ok && n == 10 && event[8].offset == UINT64_MAX &&
+      event[1].offset == event[7].offset &&
+      event[3].size == 32 && event[3].previous_size == 16 &&
+      event[3].offset == event[2].offset && event[4].size == 32 &&
+      event[4].offset == event[2].offset && event[5].previous_size == 2 &&
+      event[6].previous_size == 0 && event[5].time == event[6].time &&
+      event[6].size == 24 && event[6].alignment == 8 &&
+      event[6].sequence == event[5].sequence + 1;
+    for(i = 0; ok && i < n; i ++)
+      ok = (event[i].type == more[i]);
+  }
+#if defined(__unix__) || defined(__APPLE__)
+  {
+    // Events of a thread which ended without _Wflush_trace are kept,
+    // as well as the ones still in the buffer of the current thread
+    pthread_t thread;
+    size_t count = 0;
+    ok = ok && _Wbegin_trace(filename);
+    arena = _Wcreate_arena(10 * page_size);
+    pthread_create(&thread, NULL, trace_and_exit, arena);
+    pthread_join(thread, NULL);
+    ok = ok && _Wend_trace();
+    _Wdestroy_arena(arena);
+    file = fopen(filename, "rb");
+    if(file != NULL){
+      while(fread(event, sizeof(struct _Wtrace_event), 1, file) == 1)
+        if(event[0].type == W_TRACE_ALLOC || event[0].type == W_TRACE_CREATE)
+          count ++;
+      fclose(file);
+    }
+    remove(filename);
+    ok = ok && count == 11;
+  }
+#endif
+#else
+  ok = !_Wbegin_trace("test_trace.bin") && !_Wend_trace();
+#endif
+  assert("Allocations can be traced to a file", ok);
+}
+
+void test_shared_arena(void){
+#if defined(__linux__)
+  char name[64];
+  int fd, status;
+  pid_t pid;
+  char *p, *q;
+  void *arena;
+  bool ok;
+  snprintf(name, 64, "/weaver-test-%d", (int) getpid());
+  arena = _Wcreate_shared_arena(name, 10 * page_size, NULL);
+  ok = (arena != NULL && _Wcreate_shared_arena(name, page_size, NULL) == NULL &&
+        !_Wregister_destructor(arena, 0, free, NULL));
+  if(ok){
+    p = (char *) _Walloc(arena, 0, 0, 6);
+    strcpy(p, "left");
+    pid = fork();
+    if(pid == 0){
+      // The child gets the arena again by name, allocates in it and
+      // dies while holding the mutex
+      void *a;
+      _Wdetach_shared_arena(arena);
+      a = _Wattach_shared_arena(name, -1);
+      if(a != arena || strcmp(p, "left"))
+        _exit(1);
+      q = (char *) _Walloc(a, 0, 1, 6);
+      strcpy(q, "right");
+      pthread_mutex_lock(&(((struct arena_header *) a) -> mutex));
+      _exit(0);
+    }
+    waitpid(pid, &status, 0);
+    ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    q = ((char *) ((struct arena_header *) arena) -> right_free) + 1;
+    ok = ok && !strcmp(q, "right") && _Wmempoint(arena, 0, 1);
+    _Wtrash(arena, 1);
+    _Wtrash(arena, 1);
+    _Wtrash(arena, 0);
+  }
+  ok = ok && _Wdestroy_arena(arena);
+  shm_unlink(name);
+  assert("Shared arenas work between processes", ok);
+  arena = _Wcreate_shared_arena(NULL, 10 * page_size, &fd);
+  ok = (arena != NULL);
+  if(ok){
+    pid = fork();
+    if(pid == 0){
+      void *a;
+      _Wdetach_shared_arena(arena);
+      a = _Wattach_shared_arena(NULL, fd);
+      _exit((a == arena && _Walloc(a, 0, 0, 100) != NULL)?(0):(1));
+    }
+    waitpid(pid, &status, 0);
+    ok = WIFEXITED(status) && WEXITSTATUS(status) == 0 &&
+      ((struct arena_header *) arena) -> remaining_space <=
+      10 * page_size - sizeof(struct arena_header) - 100 &&
+      _Wattach_shared_arena(NULL, fd) == NULL; // Address already in use
+    close(fd);
+    _Wtrash(arena, 0);
+    ok = ok && _Wdestroy_arena(arena);
+  }
+  assert("Anonymous shared arenas can be inherited", ok);
+#endif
+}
+
+void test_file_arena(void){
+#if defined(__linux__)
+  char filename[64];
+  int status;
+  pid_t pid;
+  char *p, *q;
+  void *arena, *base;
+  bool ok, relocated = true;
+  FILE *file;
+  struct arena_header header;
+  snprintf(filename, 64, "/tmp/weaver-test-%d.arena", (int) getpid());
+  unlink(filename);
+  // Opening a missing file with a private mapping fails
+  ok = (_Wopen_file_arena(filename, 10 * page_size, true, NULL) == NULL);
+  arena = _Wopen_file_arena(filename, 10 * page_size, false, NULL);
+  ok = ok && (arena != NULL);
+  if(ok){
+    base = arena;
+    p = (char *) _Walloc(arena, 0, 0, 6);
+    strcpy(p, "left");
+    _Wmempoint(arena, 0, 1);
+    ok = !_Wregister_destructor(arena, 0, free, NULL) &&
+      _Wsync_file_arena(arena) && _Wclose_file_arena(arena);
+    // A new process gets the same arena and allocates in it
+    pid = fork();
+    if(pid == 0){
+      void *a = _Wopen_file_arena(filename, 0, false, NULL);
+      if(a != base || strcmp(p, "left"))
+        _exit(1);
+      _Wtrash(a, 1);
+      q = (char *) _Walloc(a, 0, 1, 6);
+      strcpy(q, "right");
+      _exit((_Wclose_file_arena(a))?(0):(1));
+    }
+    waitpid(pid, &status, 0);
+    ok = ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    // Changes in a private mapping are not written to the file
+    arena = _Wopen_file_arena(filename, 0, true, NULL);
+    ok = ok && arena == base;
+    if(arena != NULL){
+      q = ((char *) ((struct arena_header *) arena) -> right_free) + 1;
+      ok = ok && !strcmp(q, "right") && _Wmempoint(arena, 0, 1) &&
+        _Walloc(arena, 0, 0, 100) != NULL;
+      strcpy(p, "LEFT");
+      _Wclose_file_arena(arena);
+    }
+    arena = _Wopen_file_arena(filename, 0, false, &relocated);
+    ok = ok && arena == base && !relocated && !strcmp(p, "left") &&
+      ((struct arena_header *) arena) -> right_point == NULL;
+    if(arena != NULL){
+      _Wtrash(arena, 0);
+      _Wtrash(arena, 1);
+      ok = ok && _Wdestroy_arena(arena);
+    }
+  }
+  assert("File arenas keep their content between processes", ok);
+  // A file with a corrupted header is not accepted
+  file = fopen(filename, "r+b");
+  ok = (file != NULL);
+  if(ok){
+    fseek(file, (char *) &(header.remaining_space) - (char *) &header, SEEK_SET);
+    fputc(0xff, file);
+    fclose(file);
+    ok = (_Wopen_file_arena(filename, 0, false, NULL) == NULL);
+  }
+  unlink(filename);
+  assert("Corrupted file arenas are rejected", ok);
+#endif
+}
+
+struct node{
+  int value;
+  _Wrelptr next;
+};
+
+void test_relocation(void){
+  void *arena, *address, *blocker;
+  char *q;
+  bool ok;
+  arena = _Wcreate_arena(10 * page_size);
+  q = (char *) _Walloc(arena, 0, 1, 10);
+  ok = (_Wrelative(arena, NULL) == 0 && _Wabsolute(arena, 0) == NULL &&
+        _Wabsolute(arena, _Wrelative(arena, q)) == q);
+  address = arena;
+  _Wtrash(arena, 1);
+  ok = ok && _Wdestroy_arena(arena);
+  // The requested address is used when free and ignored when in use
+  arena = _Wcreate_arena_at(address, 10 * page_size, 0);
+  blocker = _Wcreate_arena_at(address, 10 * page_size, 0);
+  ok = ok && arena == address && blocker != NULL && blocker != address &&
+    _Walloc(blocker, 0, 0, 100) != NULL;
+  _Wtrash(blocker, 0);
+  ok = ok && _Wdestroy_arena(arena) && _Wdestroy_arena(blocker);
+  assert("Relative pointers and arenas at requested addresses work", ok);
+#if defined(__linux__)
+  {
+    char filename[64];
+    struct node *node;
+    _Wrelptr *root, root_offset = 0, left_free = 0;
+    bool relocated = false;
+    int i;
+    snprintf(filename, 64, "/tmp/weaver-test-reloc-%d.arena", (int) getpid());
+    unlink(filename);
+    arena = _Wopen_file_arena(filename, 10 * page_size, false, NULL);
+    ok = (arena != NULL);
+    if(ok){
+      // A list with relative pointers, spread over both stacks and
+      // between memory points
+      root = (_Wrelptr *) _Walloc(arena, 0, 0, sizeof(_Wrelptr));
+      *root = 0;
+      root_offset = _Wrelative(arena, root);
+      _Wmempoint(arena, 0, 0);
+      _Wmempoint(arena, 0, 1);
+      for(i = 0; i < 10; i ++){
+        node = (struct node *) _Walloc(arena, 0, i % 2, sizeof(struct node));
+        node -> value = i;
+        node -> next = *root;
+        *root = _Wrelative(arena, node);
+      }
+      left_free = _Wrelative(arena, ((struct arena_header *) arena) -> left_free);
+      _Wmempoint(arena, 0, 0);
+      _Walloc(arena, 0, 0, 100);
+      address = arena;
+      ok = _Wclose_file_arena(arena);
+    }
+    // The old address is in use: without 'relocated' opening fails,
+    // with it the file is mapped elsewhere and this is reported
+    blocker = _Wcreate_arena_at(address, 10 * page_size, 0);
+    ok = ok && blocker == address &&
+      _Wopen_file_arena(filename, 0, false, NULL) == NULL;
+    // A broken memory point list makes relocation fail before anything
+    // is written to the file
+    if(ok){
+      FILE *file = fopen(filename, "r+b");
+      struct arena_header before, after;
+      struct memory_point point, broken;
+      long position;
+      ok = (file != NULL &&
+            fread(&before, sizeof(struct arena_header), 1, file) == 1);
+      if(ok){
+        position = (char *) before.left_point - (char *) before.base;
+        fseek(file, position, SEEK_SET);
+        ok = (fread(&point, sizeof(struct memory_point), 1, file) == 1);
+        broken = point;
+        broken.last_memory_point = (struct memory_point *) before.base;
+        fseek(file, position, SEEK_SET);
+        fwrite(&broken, sizeof(struct memory_point), 1, file);
+        fflush(file);
+        ok = ok && _Wopen_file_arena(filename, 0, false, &relocated) == NULL;
+        fseek(file, 0, SEEK_SET);
+        ok = ok && fread(&after, sizeof(struct arena_header), 1, file) == 1 &&
+          !memcmp(&before, &after, sizeof(struct arena_header));
+        fseek(file, position, SEEK_SET);
+        fwrite(&point, sizeof(struct memory_point), 1, file);
+      }
+      if(file != NULL)
+        fclose(file);
+    }
+    arena = _Wopen_file_arena(filename, 0, false, &relocated);
+    ok = ok && arena != NULL && arena != address && relocated &&
+      ((struct arena_header *) arena) -> base == arena;
+    if(ok){
+      root = (_Wrelptr *) _Wabsolute(arena, root_offset);
+      node = (struct node *) _Wabsolute(arena, *root);
+      for(i = 9; i >= 0 && node != NULL; i --){
+        ok = ok && node -> value == i;
+        node = (struct node *) _Wabsolute(arena, node -> next);
+      }
+      ok = ok && i == -1 && node == NULL;
+      // The memory points were relocated too
+      _Wtrash(arena, 0);
+      ok = ok && _Wrelative(arena, ((struct arena_header *) arena) -> left_free) ==
+        left_free;
+      _Wtrash(arena, 0);
+      _Wtrash(arena, 0);
+      _Wtrash(arena, 1);
+      _Wtrash(arena, 1);
+      ok = ok && _Wdestroy_arena(arena);
+    }
+    if(blocker != NULL)
+      _Wdestroy_arena(blocker);
+    unlink(filename);
+    assert("File arenas are relocated when their address is in use", ok);
+  }
+#endif
+}
+
+void test_snapshot(void){
+#if defined(__linux__)
+  void *arena, *after_snapshot;
+  int *numbers, i;
+  char *right;
+  bool ok;
+  struct arena_header *header;
+  ok = (_Wcreate_arena_flags(page_size, W_SNAPSHOT | W_GROWABLE) == NULL &&
+        _Wcreate_arena_flags(page_size, W_SNAPSHOT | W_CHAINED) == NULL);
+  arena = _Wcreate_arena(page_size);
+  ok = ok && !_Wsnapshot(arena) && !_Wrestore(arena) && _Wdestroy_arena(arena);
+  arena = _Wcreate_arena_flags(64 * page_size, W_SNAPSHOT);
+  ok = ok && (arena != NULL);
+  if(ok){
+    header = (struct arena_header *) arena;
+    numbers = (int *) _Walloc(arena, 0, 0, 8 * page_size);
+    for(i = 0; i < 8 * (int) (page_size / sizeof(int)); i ++)
+      numbers[i] = i;
+    _Wmempoint(arena, 0, 1);
+    right = (char *) _Walloc(arena, 0, 1, 6);
+    strcpy(right, "right");
+    ok = _Wsnapshot(arena);
+    // Changes after the snapshot
+    numbers[0] = -1;
+    numbers[5 * page_size / sizeof(int)] = -1;
+    after_snapshot = _Walloc(arena, 0, 0, 100);
+    strcpy(right, "RIGHT");
+    _Wtrash(arena, 1);
+    ok = ok && _Wrestore(arena) && numbers[0] == 0 &&
+      numbers[5 * page_size / sizeof(int)] == (int) (5 * page_size / sizeof(int)) &&
+      !strcmp(right, "right") && header -> right_point != NULL &&
+      _Walloc(arena, 0, 0, 100) == after_snapshot;
+    // The same snapshot can be restored again
+    numbers[1] = -1;
+    ok = ok && _Wrestore(arena) && numbers[1] == 1 &&
+      _Walloc(arena, 0, 0, 100) == after_snapshot;
+    _Wtrash(arena, 1);
+    _Wtrash(arena, 0);
+    // A snapshot of the empty arena
+    ok = ok && _Wsnapshot(arena) && _Walloc(arena, 0, 0, 100) != NULL &&
+      _Wrestore(arena) && _Wdestroy_arena(arena);
+  }
+  assert("Arena snapshots can be restored", ok);
+  // A buffer which got its block after the snapshot gets a new one
+  arena = _Wcreate_arena_flags(64 * page_size, W_SNAPSHOT);
+  ok = (arena != NULL);
+  if(ok){
+    struct _Wbuffer buffer;
+    char *b1, *b2, *q;
+    _Winit_buffer(&buffer, arena, 0, 1024);
+    b1 = (char *) _Walloc_buffer(&buffer, 0, 64);
+    ok = (b1 != NULL) && _Wrestore(arena);
+    q = (char *) _Walloc(arena, 0, 0, 1024);
+    b2 = (char *) _Walloc_buffer(&buffer, 0, 64);
+    ok = ok && q != NULL && b2 != NULL && (b2 >= q + 1024 || b2 + 64 <= q);
+    _Wtrash(arena, 0);
+    ok = ok && _Wdestroy_arena(arena);
+  }
+  assert("Buffers are refilled after restoring a snapshot", ok);
+#endif
+}
+ 
 int main(int argc, char **argv){
   int semente;
   if(argc > 1)
@@ -467,8 +1669,29 @@ int main(int argc, char **argv){
   test_memorypoint3();
   test_memorypoint4();
   test_memorypoint5();
+  test_buffer();
+  test_growable();
+  test_chained();
+  test_trim();
+  test_huge_pages();
+  test_prefault();
+  test_batch();
+  test_inline();
+  test_destructors();
+  test_frame_ring();
+  test_pool();
+  test_realloc();
+  test_marks();
+  test_stats();
+  test_lock_stats();
+  test_trace();
+  test_shared_arena();
+  test_file_arena();
+  test_snapshot();
+  test_relocation();
 #if !defined(__EMSCRIPTEN__)
   test_threads();
+  test_lock_free_threads();
 #endif
   imprime_resultado();
   return 0;
@@ -0,0 +1,163 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <list>
+
+#include "../src/memory.hpp"
+
+int numero_de_testes = 0, acertos = 0, falhas = 0;
+
+void assert(const char *descricao, bool valor){
+  char pontos[72];
+  const char *s = descricao;
+  size_t tamanho_string = 0;
+  int i;
+  while(*s)
+    tamanho_string += (*s++ & 0xC0) != 0x80;
+  pontos[0] = ' ';
+  for(i = 1; i < 71 - (int) tamanho_string; i ++)
+    pontos[i] = '.';
+  pontos[i] = '\0';
+  numero_de_testes ++;
+  printf("%s%s", descricao, pontos);
+  if(valor){
+#if defined(__unix__) && !defined(__EMSCRIPTEN__)
+    printf("\033[32m[OK]\033[0m\n");
+#else
+    printf("[OK]\n");
+#endif
+    acertos ++;
+  }
+  else{
+#if defined(__unix__) && !defined(__EMSCRIPTEN__)
+    printf("\033[0;31m[FAIL]\033[0m\n");
+#else
+    printf("[FAIL]\n");
+#endif
+    falhas ++;
+  }
+}
+
+void imprime_resultado(void){
+  printf("\n%d tests: %d sucess, %d fails\n\n",
+	 numero_de_testes, acertos, falhas);
+}
+
+void test_allocator(void){
+  void *arena = _Wcreate_arena(1024 * 1024);
+  size_t initial = ((struct _Warena_fields *) arena) -> remaining_space;
+  bool inside = true, exception = false;
+  {
+    Wmempoint_guard guard(arena, 0);
+    std::vector<int, Wallocator<int> > v(Wallocator<int>(arena, 0));
+    std::list<double, Wallocator<double> > l(Wallocator<double>(arena, 1));
+    for(int i = 0; i < 1000; i ++){
+      v.push_back(i);
+      l.push_back(i);
+    }
+    for(size_t i = 0; i < v.size(); i ++){
+      if((char *) &v[i] < (char *) arena ||
+         (char *) &v[i] >= (char *) arena + 1024 * 1024)
+        inside = false;
+    }
+    for(std::list<double, Wallocator<double> >::iterator it = l.begin();
+        it != l.end(); ++ it){
+      if((char *) &*it < (char *) arena ||
+         (char *) &*it >= (char *) arena + 1024 * 1024 ||
+         ((long long) &*it) % alignof(double) != 0)
+        inside = false;
+    }
+    assert("Wallocator allocates STL containers in the arena", inside);
+    assert("Wallocator allocates in the chosen stack",
+           (char *) &v[0] < (char *) &*l.begin());
+    assert("Wallocator compares equal after rebind",
+           Wallocator<char>(v.get_allocator()) == Wallocator<char>(arena, 0) &&
+           Wallocator<char>(arena, 0) != Wallocator<char>(arena, 1));
+    try{
+      std::vector<char, Wallocator<char> > big(2 * 1024 * 1024, 'a',
+                                              Wallocator<char>(arena, 0));
+    }
+    catch(std::bad_alloc &){
+      exception = true;
+    }
+    assert("Wallocator throws bad_alloc when the arena is full", exception);
+  }
+  _Wtrash(arena, 1);
+  assert("Wmempoint_guard frees the memory when leaving its scope",
+         ((struct _Warena_fields *) arena) -> remaining_space == initial);
+  _Wdestroy_arena(arena);
+}
+
+#if defined(W_MEMORY_RESOURCE)
+void test_memory_resource(void){
+  void *arena = _Wcreate_arena(1024 * 1024);
+  size_t initial = ((struct _Warena_fields *) arena) -> remaining_space;
+  Wmemory_resource resource(arena, 1), other(arena, 1), left(arena, 0);
+  {
+    Wmempoint_guard guard(arena, 1);
+    std::pmr::vector<std::pmr::string> v(&resource);
+    v.emplace_back("A string long enough to not use small string optimization");
+    assert("Wmemory_resource allocates pmr containers in the arena",
+           (char *) v.data() >= (char *) arena &&
+           (char *) v.data() < (char *) arena + 1024 * 1024 &&
+           v[0].get_allocator().resource() == &resource);
+    assert("Wmemory_resource compares equal for the same stack",
+           resource == other && !(resource == left));
+  }
+  assert("Wmempoint_guard frees memory from a memory_resource",
+         ((struct _Warena_fields *) arena) -> remaining_space == initial);
+  _Wdestroy_arena(arena);
+}
+#endif
+
+class Counter{
+public:
+  static int alive;
+  int value;
+  Counter(int value): value(value){
+    alive ++;
+  }
+  ~Counter(){
+    alive --;
+  }
+};
+int Counter::alive = 0;
+
+struct Trivial{
+  double x, y;
+};
+
+void test_wnew(void){
+  void *arena = _Wcreate_arena(1024 * 1024);
+  struct _Warena_fields *header = (struct _Warena_fields *) arena;
+  size_t before;
+  Counter *c = Wnew<Counter>(arena, 0, 5);
+  Trivial *t;
+  {
+    Wmempoint_guard guard(arena, 0);
+    for(int i = 0; i < 10; i ++)
+      Wnew<Counter>(arena, 0, i);
+    assert("Wnew constructs objects in the arena",
+           Counter::alive == 11 && c -> value == 5);
+  }
+  assert("Destructors from Wnew run on _Wtrash", Counter::alive == 1);
+  before = header -> remaining_space;
+  t = Wnew<Trivial>(arena, 1);
+  assert("Wnew doesn't register trivial destructors",
+         before - header -> remaining_space == sizeof(Trivial) &&
+         ((long long) t) % alignof(Trivial) == 0);
+  _Wtrash(arena, 1);
+  _Wtrash(arena, 0);
+  assert("All Wnew destructors run", Counter::alive == 0 &&
+         _Wdestroy_arena(arena));
+}
+
+int main(int argc, char **argv){
+  test_allocator();
+  test_wnew();
+#if defined(W_MEMORY_RESOURCE)
+  test_memory_resource();
+#endif
+  imprime_resultado();
+  return 0;
+}